@@ -26,10 +26,41 @@ We will model a simple HTTP request access pipeline where:
   3. ContentHandler: Serves the page if all checks pass.
 - Each handler can approve, reject, or pass the request to the next handler.
 
+Compiled Pipelines:
+- Each concrete handler keeps its check in a static process(request, log) that returns whether the request moves on;
+  handle() is process() followed by the call to next. Passing a null log skips the messages.
+- freeze(head) walks a configured setNext chain once and copies the stages into a flat array of function pointers
+  (CompiledChain), so a request costs one indirect call per stage instead of a virtual call plus recursion.
+- StaticChain<Stages...> composes the same stages at compile time; the whole chain inlines into one function.
+- CompiledChain::handleBatch(requests) runs each stage over the whole batch before the next stage and compacts
+  rejected requests out of the working set, so later stages only see survivors. With a log, messages are
+  grouped by stage rather than by request.
+
+Decision Cache:
+- DecisionCacheHandler wraps the stage of another handler (e.g. AuthorizationHandler) and can be linked anywhere
+  in a setNext chain in its place. It caches accept/reject per (username, page), so repeated pairs skip the
+  wrapped check, which in production is a call to the identity service.
+- The cache is split into shards, each an LRU list plus hash index behind its own mutex, so concurrent
+  requests for different keys rarely contend. Entries expire after a TTL; rejections are cached too
+  (negative caching) with their own, usually shorter, TTL.
+- Concurrent misses on one key are single-flighted: the first caller evaluates, the others wait on its result.
+- stats() reports hits, misses, coalesced waits, LRU evictions and TTL expirations for monitoring.
+
 */
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <span>
+#include <cstdint>
+#include <stdexcept>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <future>
+#include <chrono>
+#include <functional>
+#include <memory>
 using namespace std;
 
 // Request object
@@ -41,6 +72,9 @@ struct HttpRequest
   string page;
 };
 
+// One step of a compiled chain: logs to log when non-null, returns false to stop the request
+using Stage = bool (*)(HttpRequest &request, ostream *log);
+
 // Handler interface
 class Handler
 {
@@ -50,11 +84,14 @@ protected:
 public:
   Handler() : next(nullptr) {}
   void setNext(Handler *n) { next = n; }
+  Handler *getNext() const { return next; }
   virtual void handle(HttpRequest &request)
   {
     if (next)
       next->handle(request);
   }
+  // Flat form of this handler for freeze(); nullptr if it has none
+  virtual Stage stage() const { return nullptr; }
   virtual ~Handler() {}
 };
 
@@ -62,52 +99,338 @@ public:
 class AuthenticationHandler : public Handler
 {
 public:
-  void handle(HttpRequest &request) override
+  static bool process(HttpRequest &request, ostream *log)
   {
-    cout << "AuthenticationHandler: Checking authentication...\n";
+    if (log)
+      *log << "AuthenticationHandler: Checking authentication...\n";
     if (request.authenticated)
     {
-      cout << "User '" << request.username << "' is authenticated.\n";
-      if (next)
-        next->handle(request);
-    }
-    else
-    {
-      cout << "Access denied: User is not authenticated.\n";
+      if (log)
+        *log << "User '" << request.username << "' is authenticated.\n";
+      return true;
     }
+    if (log)
+      *log << "Access denied: User is not authenticated.\n";
+    return false;
   }
+  void handle(HttpRequest &request) override
+  {
+    if (process(request, &cout) && next)
+      next->handle(request);
+  }
+  Stage stage() const override { return &process; }
 };
 
 // Concrete Handler: Authorization
 class AuthorizationHandler : public Handler
 {
 public:
-  void handle(HttpRequest &request) override
+  static bool process(HttpRequest &request, ostream *log)
   {
-    cout << "AuthorizationHandler: Checking authorization...\n";
+    if (log)
+      *log << "AuthorizationHandler: Checking authorization...\n";
     if (request.authorized)
     {
-      cout << "User '" << request.username << "' is authorized to access '" << request.page << "'.\n";
-      if (next)
-        next->handle(request);
-    }
-    else
-    {
-      cout << "Access denied: User is not authorized to access '" << request.page << "'.\n";
+      if (log)
+        *log << "User '" << request.username << "' is authorized to access '" << request.page << "'.\n";
+      return true;
     }
+    if (log)
+      *log << "Access denied: User is not authorized to access '" << request.page << "'.\n";
+    return false;
+  }
+  void handle(HttpRequest &request) override
+  {
+    if (process(request, &cout) && next)
+      next->handle(request);
   }
+  Stage stage() const override { return &process; }
 };
 
 // Concrete Handler: Content
 class ContentHandler : public Handler
 {
 public:
+  static bool process(HttpRequest &request, ostream *log)
+  {
+    if (log)
+      *log << "ContentHandler: Serving page '" << request.page << "' to user '" << request.username << "'.\n";
+    return true;
+  }
   void handle(HttpRequest &request) override
   {
-    cout << "ContentHandler: Serving page '" << request.page << "' to user '" << request.username << "'.\n";
+    process(request, &cout);
   }
+  Stage stage() const override { return &process; }
 };
 
+// Flat copy of a configured chain; later setNext calls on the handlers do not affect it
+class CompiledChain
+{
+  vector<Stage> stages;
+  vector<uint32_t> active; // indices still in flight during handleBatch; reused across batches
+
+public:
+  explicit CompiledChain(vector<Stage> s) : stages(std::move(s)) {}
+
+  size_t size() const { return stages.size(); }
+
+  // True if the request passed every stage
+  bool handle(HttpRequest &request, ostream *log = nullptr) const
+  {
+    for (Stage stage : stages)
+    {
+      if (!stage(request, log))
+        return false;
+    }
+    return true;
+  }
+
+  // Stage-major pass over the batch; returns how many requests passed every stage (see accepted())
+  size_t handleBatch(span<HttpRequest> requests, ostream *log = nullptr)
+  {
+    active.resize(requests.size());
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+      active[i] = uint32_t(i);
+    }
+    size_t live = requests.size();
+    for (Stage stage : stages)
+    {
+      size_t kept = 0;
+      for (size_t i = 0; i < live; ++i)
+      {
+        uint32_t index = active[i];
+        active[kept] = index;
+        kept += stage(requests[index], log);
+      }
+      live = kept;
+      if (live == 0)
+        break;
+    }
+    active.resize(live);
+    return live;
+  }
+
+  // Indices, in input order, of the requests accepted by the last handleBatch
+  span<const uint32_t> accepted() const { return active; }
+};
+
+// Copies the chain starting at head into a CompiledChain
+CompiledChain freeze(const Handler &head)
+{
+  vector<Stage> stages;
+  for (const Handler *h = &head; h; h = h->getNext())
+  {
+    Stage stage = h->stage();
+    if (!stage)
+      throw invalid_argument("freeze: handler has no compiled stage");
+    stages.push_back(stage);
+  }
+  return CompiledChain(std::move(stages));
+}
+
+// Chain fixed at compile time; Stages are handler types with a static process()
+template <typename... Stages>
+struct StaticChain
+{
+  static bool handle(HttpRequest &request, ostream *log = nullptr)
+  {
+    return (Stages::process(request, log) && ...);
+  }
+};
+
+struct DecisionCacheStats
+{
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t coalesced = 0; // misses that waited for another caller's evaluation
+  uint64_t evictions = 0;
+  uint64_t expirations = 0;
+  size_t size = 0;
+};
+
+struct DecisionCacheOptions
+{
+  using Clock = chrono::steady_clock;
+  size_t capacity = 65536;
+  size_t shards = 16;
+  Clock::duration ttl = chrono::seconds(60);
+  Clock::duration negativeTtl = chrono::seconds(5);
+  function<string(const HttpRequest &)> key; // defaults to (username, page)
+};
+
+// Caches the accept/reject decision of a wrapped stage; only the wrapped handler's stage is used, not its next
+class DecisionCacheHandler : public Handler
+{
+public:
+  using Clock = DecisionCacheOptions::Clock;
+  using Options = DecisionCacheOptions;
+
+private:
+  struct Entry
+  {
+    string key;
+    bool accepted;
+    Clock::time_point expires;
+  };
+
+  struct Shard
+  {
+    mutex lock;
+    list<Entry> lru; // most recently used first
+    unordered_map<string_view, list<Entry>::iterator> index; // views keys owned by lru
+    unordered_map<string, shared_future<bool>> inFlight;
+    DecisionCacheStats stats;
+  };
+
+  Stage evaluate;
+  Options options;
+  size_t shardCapacity;
+  unique_ptr<Shard[]> shards;
+
+  static string defaultKey(const HttpRequest &request)
+  {
+    string key;
+    key.reserve(request.username.size() + 1 + request.page.size());
+    key += request.username;
+    key += '\0';
+    key += request.page;
+    return key;
+  }
+
+  Shard &shardFor(const string &key)
+  {
+    uint64_t h = hash<string>{}(key) * 0x9E3779B97F4A7C15ull; // decorrelate from the map's buckets
+    return shards[(h >> 32) % options.shards];
+  }
+
+  // Caller holds shard.lock
+  void insert(Shard &shard, string key, bool accepted)
+  {
+    Clock::duration ttl = accepted ? options.ttl : options.negativeTtl;
+    shard.lru.push_front({std::move(key), accepted, Clock::now() + ttl});
+    shard.index[shard.lru.front().key] = shard.lru.begin();
+    if (shard.lru.size() > shardCapacity)
+    {
+      shard.index.erase(shard.lru.back().key);
+      shard.lru.pop_back();
+      ++shard.stats.evictions;
+    }
+  }
+
+public:
+  DecisionCacheHandler(const Handler &wrapped, Options opts = Options())
+      : evaluate(wrapped.stage()), options(std::move(opts))
+  {
+    if (!evaluate)
+      throw invalid_argument("DecisionCacheHandler: wrapped handler has no stage");
+    if (options.shards == 0 || options.capacity < options.shards)
+      throw invalid_argument("DecisionCacheHandler: capacity must allow one entry per shard");
+    if (!options.key)
+      options.key = &DecisionCacheHandler::defaultKey;
+    shardCapacity = options.capacity / options.shards;
+    shards = make_unique<Shard[]>(options.shards);
+  }
+
+  // Cached decision for request, evaluating the wrapped stage on a miss; safe to call from many threads
+  bool check(HttpRequest &request, ostream *log = nullptr)
+  {
+    string key = options.key(request);
+    Shard &shard = shardFor(key);
+    unique_lock<mutex> guard(shard.lock);
+    auto found = shard.index.find(key);
+    if (found != shard.index.end())
+    {
+      auto entry = found->second;
+      if (Clock::now() < entry->expires)
+      {
+        ++shard.stats.hits;
+        shard.lru.splice(shard.lru.begin(), shard.lru, entry);
+        bool accepted = entry->accepted;
+        guard.unlock();
+        if (log)
+          *log << "DecisionCacheHandler: cached " << (accepted ? "accept" : "reject") << " for '"
+               << request.username << "' on '" << request.page << "'.\n";
+        return accepted;
+      }
+      ++shard.stats.expirations;
+      shard.index.erase(found);
+      shard.lru.erase(entry);
+    }
+
+    auto pending = shard.inFlight.find(key);
+    if (pending != shard.inFlight.end())
+    {
+      ++shard.stats.coalesced;
+      shared_future<bool> result = pending->second;
+      guard.unlock();
+      return result.get();
+    }
+
+    ++shard.stats.misses;
+    promise<bool> result;
+    shard.inFlight.emplace(key, result.get_future().share());
+    guard.unlock();
+
+    bool accepted;
+    try
+    {
+      accepted = evaluate(request, log);
+    }
+    catch (...)
+    {
+      guard.lock();
+      shard.inFlight.erase(key);
+      guard.unlock();
+      result.set_exception(current_exception());
+      throw;
+    }
+
+    guard.lock();
+    shard.inFlight.erase(key);
+    insert(shard, std::move(key), accepted);
+    guard.unlock();
+    result.set_value(accepted);
+    return accepted;
+  }
+
+  void handle(HttpRequest &request) override
+  {
+    if (check(request, &cout) && next)
+      next->handle(request);
+  }
+
+  // Drops every cached decision; requests already being evaluated still complete
+  void clear()
+  {
+    for (size_t i = 0; i < options.shards; ++i)
+    {
+      lock_guard<mutex> guard(shards[i].lock);
+      shards[i].index.clear();
+      shards[i].lru.clear();
+    }
+  }
+
+  DecisionCacheStats stats()
+  {
+    DecisionCacheStats total;
+    for (size_t i = 0; i < options.shards; ++i)
+    {
+      lock_guard<mutex> guard(shards[i].lock);
+      const DecisionCacheStats &s = shards[i].stats;
+      total.hits += s.hits;
+      total.misses += s.misses;
+      total.coalesced += s.coalesced;
+      total.evictions += s.evictions;
+      total.expirations += s.expirations;
+      total.size += shards[i].lru.size();
+    }
+    return total;
+  }
+};
+
+#ifndef DESIGN_PATTERNS_NO_MAIN
 int main()
 {
   // Set up the chain
@@ -131,5 +454,34 @@ int main()
   cout << "\n--- Request 3: Authenticated but Not Authorized ---\n";
   authn.handle(req3);
 
+  // Frozen chain: same stages, run batch-wise
+  CompiledChain compiled = freeze(authn);
+  HttpRequest batch[] = {req1, req2, req3, {"dave", true, true, "blog.html"}};
+  cout << "\n--- Batch of 4 through the compiled chain (" << compiled.size() << " stages) ---\n";
+  size_t served = compiled.handleBatch(batch, &cout);
+  cout << "Served " << served << " of 4:";
+  for (uint32_t index : compiled.accepted())
+  {
+    cout << " " << batch[index].username;
+  }
+  cout << "\n";
+
+  using AccessChain = StaticChain<AuthenticationHandler, AuthorizationHandler, ContentHandler>;
+  cout << "\n--- Static chain, quiet ---\n";
+  cout << "carol: " << (AccessChain::handle(req3) ? "served" : "rejected") << "\n";
+
+  // Cached authorization in place of authz
+  DecisionCacheHandler cachedAuthz(authz);
+  authn.setNext(&cachedAuthz);
+  cachedAuthz.setNext(&content);
+  cout << "\n--- Cached authorization: alice twice, carol twice ---\n";
+  authn.handle(req1);
+  authn.handle(req1);
+  authn.handle(req3);
+  authn.handle(req3);
+  DecisionCacheStats stats = cachedAuthz.stats();
+  cout << "Cache: " << stats.hits << " hits, " << stats.misses << " misses, " << stats.size << " entries\n";
+
   return 0;
 }
+#endif
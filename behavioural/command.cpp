@@ -18,24 +18,67 @@ How it works in this example:
 - The client sets up the commands and assigns them to the remote control.
 
 This pattern is especially useful for implementing undo/redo, macro recording, transactional behavior, and decoupling the sender from the receiver of a request.
+
+High-Rate Execution:
+- InlineCommand is a type-erased, move-only command. Callables up to 48 bytes (a receiver pointer
+  plus a few arguments) are stored inline with no heap allocation; larger ones fall back to the heap.
+- CommandQueue is a bounded, lock-free multi-producer/single-consumer ring. Each slot carries a
+  sequence number, so producers claim slots with one CAS and never block each other.
+- RemoteControl::start() launches a worker that runs queued commands in batches; submit() may be
+  called from any number of threads. The worker sleeps on an atomic wait when the queue is empty.
+  submit(), trySubmit() and flush() throw logic_error unless the worker is running.
+- Throughput and submit-to-execute latency against vector<unique_ptr<Command>> are in bench/command.cpp.
+
+Undo/Redo Journal:
+- UndoableCommand adds undo(); the light commands remember the state they replaced.
+- CommandJournal executes commands and packs them in place into fixed-size arena blocks: a 16-byte
+  header (the type's constant operation table, size, size of the previous entry) followed by the command
+  object itself, so undo and redo walk the arena with no per-command allocation and no pointer vector.
+  The tables are per-type constants, so journals on different threads share no mutable state.
+- A command that defines bool mergeWith(const T &next) can absorb the next command of its own type
+  (updating itself if needed), e.g. repeated
+  LightOnCommands on one Light collapse into a single entry.
+- With a memory cap, whole blocks of the oldest entries are evicted once the journal exceeds it.
 */
 
 #include <iostream>
 #include <memory>
+#include <string>
 #include <vector>
+#include <atomic>
+#include <thread>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <concepts>
+#include <algorithm>
+#include <stdexcept>
 
 // Receiver
 class Light
 {
+  bool lit = false;
+
 public:
   void on()
   {
+    lit = true;
     std::cout << "Light is ON" << std::endl;
   }
   void off()
   {
+    lit = false;
     std::cout << "Light is OFF" << std::endl;
   }
+  bool isOn() const
+  {
+    return lit;
+  }
 };
 
 // Command interface
@@ -46,29 +89,285 @@ public:
   virtual void execute() = 0;
 };
 
+// Command that can revert what its last execute() did
+class UndoableCommand : public Command
+{
+public:
+  virtual void undo() = 0;
+};
+
 // Concrete Commands
-class LightOnCommand : public Command
+class LightOnCommand : public UndoableCommand
 {
   Light &light;
+  bool wasOn = false;
 
 public:
   LightOnCommand(Light &l) : light(l) {}
   void execute() override
   {
+    wasOn = light.isOn();
     light.on();
   }
+  void undo() override
+  {
+    if (!wasOn)
+      light.off();
+  }
+  // Turning the same light on twice in a row is one step to undo
+  bool mergeWith(const LightOnCommand &next) const
+  {
+    return &next.light == &light;
+  }
 };
 
-class LightOffCommand : public Command
+class LightOffCommand : public UndoableCommand
 {
   Light &light;
+  bool wasOn = false;
 
 public:
   LightOffCommand(Light &l) : light(l) {}
   void execute() override
   {
+    wasOn = light.isOn();
     light.off();
   }
+  void undo() override
+  {
+    if (wasOn)
+      light.on();
+  }
+  bool mergeWith(const LightOffCommand &next) const
+  {
+    return &next.light == &light;
+  }
+};
+
+// Type-erased, move-only command; small callables live in the object itself
+class InlineCommand
+{
+public:
+  static constexpr std::size_t inlineSize = 48;
+
+private:
+  struct Ops
+  {
+    void (*invoke)(void *storage);
+    void (*move)(void *from, void *to); // leaves `from` destroyed
+    void (*destroy)(void *storage);
+  };
+
+  template <typename F>
+  static constexpr bool storedInline = sizeof(F) <= inlineSize && alignof(F) <= alignof(void *) &&
+                                       std::is_nothrow_move_constructible_v<F>;
+
+  template <typename F>
+  static const Ops *opsFor()
+  {
+    if constexpr (storedInline<F>)
+    {
+      static constexpr Ops ops{
+          [](void *p)
+          { (*static_cast<F *>(p))(); },
+          [](void *from, void *to)
+          {
+            new (to) F(std::move(*static_cast<F *>(from)));
+            static_cast<F *>(from)->~F();
+          },
+          [](void *p)
+          { static_cast<F *>(p)->~F(); }};
+      return &ops;
+    }
+    else
+    {
+      static constexpr Ops ops{
+          [](void *p)
+          { (**static_cast<F **>(p))(); },
+          [](void *from, void *to)
+          { *static_cast<F **>(to) = *static_cast<F **>(from); },
+          [](void *p)
+          { delete *static_cast<F **>(p); }};
+      return &ops;
+    }
+  }
+
+  alignas(void *) unsigned char storage[inlineSize];
+  const Ops *ops = nullptr;
+
+public:
+  InlineCommand() = default;
+  template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InlineCommand> &&
+                                                    std::is_invocable_v<std::decay_t<F> &>>>
+  InlineCommand(F &&f)
+  {
+    emplace(std::forward<F>(f));
+  }
+  InlineCommand(std::unique_ptr<Command> command)
+  {
+    emplace(std::move(command));
+  }
+  InlineCommand(InlineCommand &&other) noexcept : ops(other.ops)
+  {
+    if (ops)
+      ops->move(other.storage, storage);
+    other.ops = nullptr;
+  }
+  InlineCommand &operator=(InlineCommand &&other) noexcept
+  {
+    if (this != &other)
+    {
+      reset();
+      ops = other.ops;
+      if (ops)
+        ops->move(other.storage, storage);
+      other.ops = nullptr;
+    }
+    return *this;
+  }
+  ~InlineCommand()
+  {
+    reset();
+  }
+
+  // Replaces the stored command, constructing the new one in place
+  template <typename F>
+  void emplace(F &&f)
+  {
+    using Stored = std::decay_t<F>;
+    if constexpr (std::is_convertible_v<F &&, std::unique_ptr<Command>>)
+    {
+      emplace([c = std::unique_ptr<Command>(std::forward<F>(f))]()
+              { c->execute(); });
+    }
+    else
+    {
+      reset();
+      if constexpr (storedInline<Stored>)
+        new (storage) Stored(std::forward<F>(f));
+      else
+        *reinterpret_cast<Stored **>(storage) = new Stored(std::forward<F>(f));
+      ops = opsFor<Stored>();
+    }
+  }
+  void reset()
+  {
+    if (ops)
+      ops->destroy(storage);
+    ops = nullptr;
+  }
+  void operator()()
+  {
+    ops->invoke(storage);
+  }
+  explicit operator bool() const
+  {
+    return ops != nullptr;
+  }
+};
+
+// Bounded lock-free queue: any number of producers, one consumer.
+// Slot sequence == position: free for the producer at that position; == position + 1: ready to run.
+class CommandQueue
+{
+  struct alignas(64) Slot
+  {
+    std::atomic<std::size_t> sequence;
+    InlineCommand command;
+  };
+
+  std::unique_ptr<Slot[]> slots;
+  std::size_t mask;
+  alignas(64) std::atomic<std::size_t> enqueuePos{0};
+  alignas(64) std::size_t dequeuePos = 0;
+  std::atomic<std::size_t> ranCount{0};
+
+public:
+  explicit CommandQueue(std::size_t capacity = 4096)
+  {
+    std::size_t size = 2;
+    while (size < capacity)
+      size *= 2;
+    slots = std::make_unique<Slot[]>(size);
+    mask = size - 1;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  std::size_t capacity() const { return mask + 1; }
+  // Commands pushed so far
+  std::size_t pushed() const { return enqueuePos.load(); }
+  // Commands run so far; equals pushed() once the queue has drained
+  std::size_t completed() const { return ranCount.load(std::memory_order_acquire); }
+
+  // False if the queue is full; f is only consumed on success. If constructing the command throws, the
+  // claimed slot is published as a no-op so the consumer does not stall on it, and the exception propagates.
+  template <typename F>
+  bool tryPush(F &&f)
+  {
+    std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      Slot &slot = slots[pos & mask];
+      std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      std::intptr_t diff = std::intptr_t(sequence) - std::intptr_t(pos);
+      if (diff == 0)
+      {
+        if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          try
+          {
+            slot.command.emplace(std::forward<F>(f));
+          }
+          catch (...)
+          {
+            slot.command.emplace([]() {});
+            slot.sequence.store(pos + 1, std::memory_order_release);
+            throw;
+          }
+          slot.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff < 0)
+        return false;
+      else
+        pos = enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+
+  // Consumer only
+  bool empty() const
+  {
+    return slots[dequeuePos & mask].sequence.load(std::memory_order_acquire) != dequeuePos + 1;
+  }
+
+  // Consumer only: runs up to maxBatch ready commands in place, freeing each slot afterwards
+  template <typename OnError>
+  std::size_t runBatch(std::size_t maxBatch, OnError &&onError)
+  {
+    std::size_t ran = 0;
+    while (ran < maxBatch && !empty())
+    {
+      Slot &slot = slots[dequeuePos & mask];
+      try
+      {
+        slot.command();
+      }
+      catch (...)
+      {
+        onError();
+      }
+      slot.command.reset();
+      slot.sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+      ++dequeuePos;
+      ++ran;
+    }
+    ranCount.store(dequeuePos, std::memory_order_release);
+    return ran;
+  }
 };
 
 // Invoker
@@ -77,7 +376,65 @@ class RemoteControl
   std::vector<std::unique_ptr<Command>> onCommands;
   std::vector<std::unique_ptr<Command>> offCommands;
 
+  // Queued mode
+  std::unique_ptr<CommandQueue> queue;
+  std::thread worker;
+  std::size_t batchSize = 256;
+  std::atomic<bool> stopping{false};
+  std::atomic<bool> sleeping{false};
+  std::atomic<std::uint32_t> wakeups{0};
+  std::atomic<std::uint64_t> executed{0};
+  std::atomic<std::uint64_t> failures{0};
+
+  void workerLoop()
+  {
+    auto onError = [this]()
+    { failures.fetch_add(1, std::memory_order_relaxed); };
+    for (;;)
+    {
+      std::size_t ran = queue->runBatch(batchSize, onError);
+      if (ran)
+      {
+        executed.fetch_add(ran, std::memory_order_release);
+        continue;
+      }
+      if (stopping.load())
+        return;
+      for (int spin = 0; spin < 64 && queue->empty(); ++spin)
+      {
+        std::this_thread::yield();
+      }
+      std::uint32_t seen = wakeups.load();
+      sleeping.store(true);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (queue->empty() && !stopping.load())
+        wakeups.wait(seen);
+      sleeping.store(false);
+    }
+  }
+
+  void checkStarted(const char *what) const
+  {
+    if (!worker.joinable())
+      throw std::logic_error(std::string("RemoteControl::") + what + ": call start() first");
+  }
+
+  void wakeWorker()
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed))
+    {
+      wakeups.fetch_add(1);
+      wakeups.notify_one();
+    }
+  }
+
 public:
+  ~RemoteControl()
+  {
+    stop();
+  }
+
   void setCommand(size_t slot, std::unique_ptr<Command> onCommand, std::unique_ptr<Command> offCommand)
   {
     if (slot >= onCommands.size())
@@ -110,8 +467,297 @@ public:
       std::cout << "No OFF command set for slot " << slot << std::endl;
     }
   }
+
+  // Starts the worker; configure slots with setCommand() before calling this
+  void start(std::size_t capacity = 4096, std::size_t batch = 256)
+  {
+    if (worker.joinable())
+      return;
+    queue = std::make_unique<CommandQueue>(capacity);
+    batchSize = batch;
+    stopping = false;
+    worker = std::thread(&RemoteControl::workerLoop, this);
+  }
+  // Runs everything already queued, then joins the worker
+  void stop()
+  {
+    if (!worker.joinable())
+      return;
+    stopping = true;
+    wakeups.fetch_add(1);
+    wakeups.notify_one();
+    worker.join();
+  }
+
+  // Thread-safe while started; spins with yield while the queue is full
+  template <typename F>
+  void submit(F &&command)
+  {
+    checkStarted("submit");
+    while (!queue->tryPush(std::forward<F>(command)))
+    {
+      std::this_thread::yield();
+    }
+    wakeWorker();
+  }
+  template <typename F>
+  bool trySubmit(F &&command)
+  {
+    checkStarted("trySubmit");
+    if (!queue->tryPush(std::forward<F>(command)))
+      return false;
+    wakeWorker();
+    return true;
+  }
+  void submitOnButton(std::size_t slot)
+  {
+    submit([this, slot]()
+           { pressOnButton(slot); });
+  }
+  void submitOffButton(std::size_t slot)
+  {
+    submit([this, slot]()
+           { pressOffButton(slot); });
+  }
+  // Blocks until every command submitted before the call has run
+  void flush()
+  {
+    checkStarted("flush");
+    std::size_t target = queue->pushed();
+    while (queue->completed() < target)
+    {
+      std::this_thread::yield();
+    }
+  }
+  std::uint64_t executedCount() const { return executed.load(); }
+  std::uint64_t failureCount() const { return failures.load(); }
+};
+
+// Undo/redo history packed into fixed-size blocks; single-threaded
+class CommandJournal
+{
+  struct Ops
+  {
+    void (*undo)(void *command);
+    void (*redo)(void *command);
+    bool (*merge)(void *previous, const void *next); // null if the type never merges
+    void (*destroy)(void *command);
+  };
+
+  struct Header
+  {
+    const Ops *ops;         // one constant table per command type, so it also identifies the type
+    std::uint16_t size;     // header plus command, rounded up to 8 bytes
+    std::uint16_t prevSize; // size of the entry before this one in the block, 0 if first
+    std::uint32_t unused;
+  };
+  static_assert(sizeof(Header) == 16);
+
+  struct Block
+  {
+    std::unique_ptr<std::byte[]> data;
+    std::size_t used = 0;
+    std::size_t count = 0;
+    std::uint16_t lastSize = 0; // size of the last entry
+  };
+
+  template <typename T>
+  static const Ops *opsFor()
+  {
+    static constexpr Ops ops{
+        [](void *c)
+        { static_cast<T *>(c)->undo(); },
+        [](void *c)
+        { static_cast<T *>(c)->execute(); },
+        []()
+        {
+          bool (*merge)(void *, const void *) = nullptr;
+          if constexpr (requires(T &a, const T &b) { { a.mergeWith(b) } -> std::convertible_to<bool>; })
+            merge = [](void *previous, const void *next)
+            { return static_cast<T *>(previous)->mergeWith(*static_cast<const T *>(next)); };
+          return merge;
+        }(),
+        [](void *c)
+        { static_cast<T *>(c)->~T(); }};
+    return &ops;
+  }
+
+  static constexpr std::size_t entrySize(std::size_t commandSize)
+  {
+    return (sizeof(Header) + commandSize + 7) / 8 * 8;
+  }
+
+  std::deque<Block> blocks;
+  std::size_t blockSize;
+  std::size_t memoryCap;
+  // Entries before the cursor are applied; entries after it can be redone
+  std::size_t cursorBlock = 0;
+  std::size_t cursorOffset = 0;
+  std::size_t applied = 0;
+  std::size_t total = 0;
+  std::size_t mergedCount = 0;
+  std::size_t evictedCount = 0;
+
+  Header &headerAt(std::size_t block, std::size_t offset)
+  {
+    return *reinterpret_cast<Header *>(blocks[block].data.get() + offset);
+  }
+  void *commandAt(std::size_t block, std::size_t offset)
+  {
+    return blocks[block].data.get() + offset + sizeof(Header);
+  }
+
+  // Locates the entry just before the cursor; false at the start of the history
+  bool previousEntry(std::size_t &block, std::size_t &offset)
+  {
+    block = cursorBlock;
+    offset = cursorOffset;
+    while (offset == 0)
+    {
+      if (block == 0)
+        return false;
+      --block;
+      offset = blocks[block].used;
+    }
+    std::size_t size = offset == blocks[block].used ? blocks[block].lastSize : headerAt(block, offset).prevSize;
+    offset -= size;
+    return true;
+  }
+
+  void destroyRange(std::size_t block, std::size_t offset, std::size_t end)
+  {
+    while (offset < end)
+    {
+      Header &header = headerAt(block, offset);
+      header.ops->destroy(commandAt(block, offset));
+      --blocks[block].count;
+      --total;
+      offset += header.size;
+    }
+  }
+
+  // Drops everything after the cursor, as any new command invalidates redo
+  void truncate()
+  {
+    for (std::size_t b = blocks.size(); b-- > cursorBlock + 1;)
+    {
+      destroyRange(b, 0, blocks[b].used);
+      blocks.pop_back();
+    }
+    if (blocks.empty() || cursorOffset == blocks[cursorBlock].used)
+      return;
+    Block &block = blocks[cursorBlock];
+    std::uint16_t last = cursorOffset ? headerAt(cursorBlock, cursorOffset).prevSize : 0;
+    destroyRange(cursorBlock, cursorOffset, block.used);
+    block.used = cursorOffset;
+    block.lastSize = last;
+  }
+
+  void evict()
+  {
+    while (memoryUsed() > memoryCap && cursorBlock > 0)
+    {
+      Block &oldest = blocks.front();
+      std::size_t count = oldest.count;
+      destroyRange(0, 0, oldest.used);
+      evictedCount += count;
+      applied -= count;
+      blocks.pop_front();
+      --cursorBlock;
+    }
+  }
+
+public:
+  explicit CommandJournal(std::size_t memoryCapBytes = std::numeric_limits<std::size_t>::max(),
+                          std::size_t blockBytes = 64 * 1024)
+      : blockSize(blockBytes), memoryCap(memoryCapBytes) {}
+  ~CommandJournal()
+  {
+    for (std::size_t b = 0; b < blocks.size(); ++b)
+    {
+      destroyRange(b, 0, blocks[b].used);
+    }
+  }
+  CommandJournal(const CommandJournal &) = delete;
+  CommandJournal &operator=(const CommandJournal &) = delete;
+
+  // Runs the command and records it, merging into the previous entry when the type allows it
+  template <typename T>
+  void execute(T command)
+  {
+    static_assert(alignof(T) <= 8 && entrySize(sizeof(T)) <= 0xFFFF, "command must be small and 8-byte aligned");
+    command.execute();
+    truncate();
+    const Ops *ops = opsFor<T>();
+    std::size_t block, offset;
+    if (ops->merge && previousEntry(block, offset) && headerAt(block, offset).ops == ops &&
+        ops->merge(commandAt(block, offset), &command))
+    {
+      ++mergedCount;
+      return;
+    }
+
+    std::size_t size = entrySize(sizeof(T));
+    if (blocks.empty() || blocks.back().used + size > blockSize)
+    {
+      Block fresh;
+      fresh.data = std::make_unique<std::byte[]>(std::max(blockSize, size));
+      blocks.push_back(std::move(fresh));
+      cursorBlock = blocks.size() - 1;
+      cursorOffset = 0;
+    }
+    Block &target = blocks.back();
+    Header header{ops, std::uint16_t(size), std::uint16_t(target.used ? target.lastSize : 0), 0};
+    std::memcpy(target.data.get() + target.used, &header, sizeof(header));
+    new (target.data.get() + target.used + sizeof(Header)) T(std::move(command));
+    target.used += size;
+    target.lastSize = std::uint16_t(size);
+    ++target.count;
+    cursorOffset = target.used;
+    ++applied;
+    ++total;
+    evict();
+  }
+
+  bool undo()
+  {
+    std::size_t block, offset;
+    if (!previousEntry(block, offset))
+      return false;
+    headerAt(block, offset).ops->undo(commandAt(block, offset));
+    cursorBlock = block;
+    cursorOffset = offset;
+    --applied;
+    return true;
+  }
+
+  bool redo()
+  {
+    while (cursorBlock < blocks.size() && cursorOffset == blocks[cursorBlock].used)
+    {
+      if (cursorBlock + 1 == blocks.size())
+        return false;
+      ++cursorBlock;
+      cursorOffset = 0;
+    }
+    if (cursorBlock >= blocks.size())
+      return false;
+    Header &header = headerAt(cursorBlock, cursorOffset);
+    header.ops->redo(commandAt(cursorBlock, cursorOffset));
+    cursorOffset += header.size;
+    ++applied;
+    return true;
+  }
+
+  std::size_t undoCount() const { return applied; }
+  std::size_t redoCount() const { return total - applied; }
+  std::size_t size() const { return total; }
+  std::size_t merged() const { return mergedCount; }
+  std::size_t evicted() const { return evictedCount; }
+  std::size_t memoryUsed() const { return blocks.size() * blockSize; }
 };
 
+#ifndef DESIGN_PATTERNS_NO_MAIN
 // Demo
 int main()
 {
@@ -129,5 +775,26 @@ int main()
   std::cout << "Pressing ON button for slot 1 (no command set):" << std::endl;
   remote.pressOnButton(1);
 
+  std::cout << "Queued: worker thread runs the buttons and an inline lambda command:" << std::endl;
+  remote.start();
+  remote.submitOnButton(0);
+  remote.submit([&livingRoomLight]()
+                { livingRoomLight.off(); });
+  remote.submit(std::make_unique<LightOnCommand>(livingRoomLight));
+  remote.flush();
+  remote.stop();
+
+  std::cout << "Journal: kitchen ON, ON (merged), OFF, then undo twice and redo once:" << std::endl;
+  Light kitchenLight;
+  CommandJournal journal;
+  journal.execute(LightOnCommand(kitchenLight));
+  journal.execute(LightOnCommand(kitchenLight));
+  journal.execute(LightOffCommand(kitchenLight));
+  std::cout << "Entries: " << journal.size() << ", merged: " << journal.merged() << std::endl;
+  journal.undo();
+  journal.undo();
+  journal.redo();
+
   return 0;
 }
+#endif
@@ -22,23 +22,250 @@ We will model a simple interpreter for arithmetic expressions involving addition
 - Each number and operator is an expression.
 - The interpreter will parse and evaluate the expression.
 
+For expressions that are evaluated many times:
+- parse() and parseMany() scan a string_view directly, support parentheses and throw ParseError with the line and column of bad input.
+- Trees are at most Parser::maxTreeDepth levels deep (a flat chain "1 + 1 + ..." is as deep as it has terms), because
+  interpret(), compile(), optimize() and destruction all recurse once per level; deeper input is a ParseError.
+- parse() can place all nodes of one tree in an ExpressionArena (one monotonic buffer instead of a heap allocation per node).
+- compile() lowers a tree into flat postfix bytecode that a non-recursive loop evaluates without virtual calls.
+- Variables (e.g. "price - discount + 5") are bound per row; evaluateBatch() runs one compiled expression over whole columns of rows at once.
+- optimize() folds constants, shares identical subtrees (hash-consing) and re-evaluates only the parts whose variables changed.
+bench/interpreter.cpp compares parsing, tree-walk, bytecode, batch and optimized evaluation.
+
 */
 
 #include <iostream>
 #include <string>
-#include <sstream>
+#include <string_view>
+#include <charconv>
+#include <stdexcept>
 #include <vector>
+#include <span>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
 using namespace std;
 
+// Bytecode: flat postfix program produced by Expression::compile()
+enum class OpCode
+{
+  Push,         // push operand
+  Load,         // push row[operand]
+  Add,          // pop b, pop a, push a + b
+  Subtract,     // pop b, pop a, push a - b
+  AddConst,     // top += operand
+  SubtractConst // top -= operand
+};
+
+struct Instruction
+{
+  OpCode op;
+  int operand;
+};
+
+// Expression DAG built by optimize(): identical subtrees share one node (hash-consing) and
+// constant arithmetic is folded while it is built. Children always precede their parents.
+class ExpressionGraph
+{
+public:
+  enum class Kind : uint8_t
+  {
+    Constant,
+    Variable,
+    Add,
+    Subtract
+  };
+  struct Node
+  {
+    Kind kind;
+    int value; // Constant value or variable column
+    uint32_t left, right;
+
+    bool operator==(const Node &) const = default;
+  };
+
+  // Builders called once per source node by Expression::lower()
+  uint32_t constant(int v)
+  {
+    ++sourceNodes;
+    return intern({Kind::Constant, v, 0, 0});
+  }
+  uint32_t variable(size_t column)
+  {
+    ++sourceNodes;
+    return intern({Kind::Variable, int(column), 0, 0});
+  }
+  uint32_t add(uint32_t a, uint32_t b)
+  {
+    ++sourceNodes;
+    return addNode(a, b);
+  }
+  uint32_t subtract(uint32_t a, uint32_t b)
+  {
+    ++sourceNodes;
+    return subtractNode(a, b);
+  }
+
+  const vector<Node> &getNodes() const { return nodes; }
+  size_t sourceNodes = 0, constantsFolded = 0, sharedSubtrees = 0;
+
+  // Wrapping arithmetic, so folding never introduces overflow that the tree would not have
+  static int wrapAdd(int a, int b) { return int(unsigned(a) + unsigned(b)); }
+  static int wrapSubtract(int a, int b) { return int(unsigned(a) - unsigned(b)); }
+
+private:
+  struct NodeHash
+  {
+    size_t operator()(const Node &n) const
+    {
+      uint64_t h = (uint64_t(n.kind) << 32) ^ uint32_t(n.value);
+      h = h * 0x9e3779b97f4a7c15ULL ^ n.left;
+      h = h * 0x9e3779b97f4a7c15ULL ^ n.right;
+      return size_t(h ^ (h >> 29));
+    }
+  };
+  vector<Node> nodes;
+  unordered_map<Node, uint32_t, NodeHash> index;
+
+  const Node &at(uint32_t id) const { return nodes[id]; }
+  bool isConstant(uint32_t id) const { return nodes[id].kind == Kind::Constant; }
+
+  uint32_t intern(const Node &n)
+  {
+    auto [it, added] = index.try_emplace(n, uint32_t(nodes.size()));
+    if (added)
+      nodes.push_back(n);
+    else
+      ++sharedSubtrees;
+    return it->second;
+  }
+  // Canonical sums keep constants on the right: (x + 3) + 4 becomes x + 7
+  uint32_t addNode(uint32_t a, uint32_t b)
+  {
+    if (isConstant(a) && isConstant(b))
+    {
+      ++constantsFolded;
+      return intern({Kind::Constant, wrapAdd(at(a).value, at(b).value), 0, 0});
+    }
+    if (isConstant(a) || (!isConstant(b) && a > b))
+      swap(a, b);
+    if (isConstant(b))
+    {
+      if (at(b).value == 0)
+      {
+        ++constantsFolded;
+        return a;
+      }
+      if (at(a).kind == Kind::Add && isConstant(at(a).right))
+      {
+        ++constantsFolded;
+        int sum = wrapAdd(at(at(a).right).value, at(b).value);
+        return addNode(at(a).left, intern({Kind::Constant, sum, 0, 0}));
+      }
+    }
+    return intern({Kind::Add, 0, a, b});
+  }
+  uint32_t subtractNode(uint32_t a, uint32_t b)
+  {
+    if (isConstant(a) && isConstant(b))
+    {
+      ++constantsFolded;
+      return intern({Kind::Constant, wrapSubtract(at(a).value, at(b).value), 0, 0});
+    }
+    if (a == b)
+    {
+      ++constantsFolded;
+      return intern({Kind::Constant, 0, 0, 0});
+    }
+    if (isConstant(b))
+      return addNode(a, intern({Kind::Constant, wrapSubtract(0, at(b).value), 0, 0}));
+    return intern({Kind::Subtract, 0, a, b});
+  }
+};
+
+// Context: variable values for one evaluation, indexed by column
+using Row = span<const int>;
+
+// Symbol table: assigns each variable name a column in the evaluation rows
+class Variables
+{
+  struct Hash
+  {
+    using is_transparent = void;
+    size_t operator()(string_view s) const { return hash<string_view>{}(s); }
+  };
+  vector<string> names;
+  unordered_map<string, size_t, Hash, equal_to<>> columns;
+
+public:
+  size_t declare(string_view name)
+  {
+    auto it = columns.find(name);
+    if (it != columns.end())
+      return it->second;
+    names.emplace_back(name);
+    columns.emplace(names.back(), names.size() - 1);
+    return names.size() - 1;
+  }
+  const string &name(size_t column) const { return names.at(column); }
+  size_t size() const { return names.size(); }
+};
+
 // Abstract Expression
 class Expression
 {
 public:
-  virtual int interpret() const = 0;
+  virtual int interpret(Row row) const = 0;
+  int interpret() const { return interpret(Row()); }
+  virtual void emit(vector<Instruction> &code) const = 0;
+  virtual uint32_t lower(ExpressionGraph &graph) const = 0;
   virtual ~Expression() {}
 };
 
+// Frees heap nodes; arena nodes are only destroyed, their memory goes away with the arena
+struct ExpressionDeleter
+{
+  bool fromArena = false;
+
+  ExpressionDeleter(bool arena = false) : fromArena(arena) {}
+  template <typename T>
+  ExpressionDeleter(default_delete<T>) {}
+  void operator()(Expression *e) const
+  {
+    if (fromArena)
+      e->~Expression();
+    else
+      delete e;
+  }
+};
+
+using ExpressionPtr = unique_ptr<Expression, ExpressionDeleter>;
+
+// Per-tree monotonic arena: nodes are bump-allocated and released all at once.
+// The arena must outlive every tree built in it.
+class ExpressionArena
+{
+  pmr::monotonic_buffer_resource memory;
+
+public:
+  template <typename T, typename... Args>
+  ExpressionPtr make(Args &&...args)
+  {
+    void *p = memory.allocate(sizeof(T), alignof(T));
+    return ExpressionPtr(new (p) T(std::forward<Args>(args)...), ExpressionDeleter(true));
+  }
+};
+
+template <typename T, typename... Args>
+ExpressionPtr makeExpression(ExpressionArena *arena, Args &&...args)
+{
+  if (arena)
+    return arena->make<T>(std::forward<Args>(args)...);
+  return ExpressionPtr(new T(std::forward<Args>(args)...));
+}
+
 // Terminal Expression: Number
 class NumberExpression : public Expression
 {
@@ -46,72 +273,562 @@ class NumberExpression : public Expression
 
 public:
   NumberExpression(int n) : number(n) {}
-  int interpret() const override
+  using Expression::interpret;
+  int interpret(Row) const override
   {
     return number;
   }
+  void emit(vector<Instruction> &code) const override
+  {
+    code.push_back({OpCode::Push, number});
+  }
+  uint32_t lower(ExpressionGraph &graph) const override
+  {
+    return graph.constant(number);
+  }
+};
+
+// Terminal Expression: Variable, read from the row's column
+class VariableExpression : public Expression
+{
+  string name;
+  size_t column;
+
+public:
+  VariableExpression(string_view n, size_t c) : name(n), column(c) {}
+  using Expression::interpret;
+  int interpret(Row row) const override
+  {
+    if (column >= row.size())
+      throw out_of_range("variable '" + name + "' is not bound");
+    return row[column];
+  }
+  void emit(vector<Instruction> &code) const override
+  {
+    code.push_back({OpCode::Load, int(column)});
+  }
+  uint32_t lower(ExpressionGraph &graph) const override
+  {
+    return graph.variable(column);
+  }
 };
 
+// Emits a binary operator after both operands; a right operand that is a number
+// ("Push n; op") becomes a single immediate instruction
+void emitBinary(vector<Instruction> &code, OpCode op, OpCode constOp)
+{
+  if (code.back().op == OpCode::Push)
+  {
+    code.back().op = constOp;
+  }
+  else
+  {
+    code.push_back({op, 0});
+  }
+}
+
 // NonTerminal Expression: Addition
 class AddExpression : public Expression
 {
-  unique_ptr<Expression> left, right;
+  ExpressionPtr left, right;
 
 public:
-  AddExpression(unique_ptr<Expression> l, unique_ptr<Expression> r)
+  AddExpression(ExpressionPtr l, ExpressionPtr r)
       : left(move(l)), right(move(r)) {}
-  int interpret() const override
+  using Expression::interpret;
+  int interpret(Row row) const override
+  {
+    return left->interpret(row) + right->interpret(row);
+  }
+  void emit(vector<Instruction> &code) const override
   {
-    return left->interpret() + right->interpret();
+    left->emit(code);
+    right->emit(code);
+    emitBinary(code, OpCode::Add, OpCode::AddConst);
+  }
+  uint32_t lower(ExpressionGraph &graph) const override
+  {
+    uint32_t l = left->lower(graph);
+    return graph.add(l, right->lower(graph));
   }
 };
 
 // NonTerminal Expression: Subtraction
 class SubtractExpression : public Expression
 {
-  unique_ptr<Expression> left, right;
+  ExpressionPtr left, right;
 
 public:
-  SubtractExpression(unique_ptr<Expression> l, unique_ptr<Expression> r)
+  SubtractExpression(ExpressionPtr l, ExpressionPtr r)
       : left(move(l)), right(move(r)) {}
-  int interpret() const override
+  using Expression::interpret;
+  int interpret(Row row) const override
+  {
+    return left->interpret(row) - right->interpret(row);
+  }
+  void emit(vector<Instruction> &code) const override
   {
-    return left->interpret() - right->interpret();
+    left->emit(code);
+    right->emit(code);
+    emitBinary(code, OpCode::Subtract, OpCode::SubtractConst);
+  }
+  uint32_t lower(ExpressionGraph &graph) const override
+  {
+    uint32_t l = left->lower(graph);
+    return graph.subtract(l, right->lower(graph));
   }
 };
 
-// Parser for simple expressions like "5 + 3 - 2"
-unique_ptr<Expression> parse(const string &expr)
+// Parse error with the location of the offending character
+class ParseError : public runtime_error
 {
-  istringstream iss(expr);
-  vector<unique_ptr<Expression>> terms;
-  vector<char> ops;
-  int num;
-  iss >> num;
-  terms.push_back(make_unique<NumberExpression>(num));
-  char op;
-  while (iss >> op)
+public:
+  size_t position; // Offset into the parsed buffer
+  size_t line, column; // 1-based
+
+  ParseError(const string &message, size_t pos, size_t ln, size_t col)
+      : runtime_error("line " + to_string(ln) + ", column " + to_string(col) + ": " + message),
+        position(pos), line(ln), column(col) {}
+};
+
+// Hand-written scanner and recursive-descent parser over a string_view (no copies, no locale)
+// Grammar:  expression := operand (('+' | '-') operand)*
+//           operand    := integer | variable | '(' expression ')'
+// Operators are left-associative. Parenthesis nesting bounds the parser's own recursion; tree height bounds the
+// recursion of everything that walks the tree later.
+class Parser
+{
+  string_view source;
+  size_t pos;
+  size_t line, lineStart;
+  size_t depth = 0;
+  ExpressionArena *arena;
+  Variables *variables;
+
+  static constexpr size_t maxDepth = 256;
+
+public:
+  static constexpr size_t maxTreeDepth = 10000;
+
+private:
+
+  static bool isIdentifierStart(char c)
+  {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+  }
+  static bool isIdentifierChar(char c)
   {
-    ops.push_back(op);
-    iss >> num;
-    terms.push_back(make_unique<NumberExpression>(num));
+    return isIdentifierStart(c) || (c >= '0' && c <= '9');
   }
-  // Build the expression tree left-to-right (no operator precedence)
-  unique_ptr<Expression> result = move(terms[0]);
-  for (size_t i = 0; i < ops.size(); ++i)
+
+  void skipSpaces()
   {
-    if (ops[i] == '+')
+    while (pos < source.size() && (source[pos] == ' ' || source[pos] == '\t' || source[pos] == '\r'))
+      ++pos;
+  }
+  bool atLineEnd() const
+  {
+    return pos == source.size() || source[pos] == '\n';
+  }
+  // height receives the levels of the returned tree
+  ExpressionPtr parseOperand(size_t &height)
+  {
+    skipSpaces();
+    if (atLineEnd())
+      fail("expected a number or '('");
+    if (source[pos] == '(')
+    {
+      if (++depth > maxDepth)
+        fail("parentheses nested too deeply");
+      ++pos;
+      ExpressionPtr inner = parseExpression(height);
+      skipSpaces();
+      if (atLineEnd() || source[pos] != ')')
+        fail("expected ')'");
+      ++pos;
+      --depth;
+      return inner;
+    }
+    if (isIdentifierStart(source[pos]))
     {
-      result = make_unique<AddExpression>(move(result), move(terms[i + 1]));
+      size_t start = pos;
+      while (pos < source.size() && isIdentifierChar(source[pos]))
+        ++pos;
+      string_view name = source.substr(start, pos - start);
+      if (!variables)
+      {
+        pos = start;
+        fail("unknown variable '" + string(name) + "'");
+      }
+      height = 1;
+      return makeExpression<VariableExpression>(arena, name, variables->declare(name));
     }
-    else if (ops[i] == '-')
+    int value = 0;
+    auto [end, ec] = from_chars(source.data() + pos, source.data() + source.size(), value);
+    if (ec == errc::result_out_of_range)
+      fail("integer out of range");
+    if (ec != errc())
+      fail(string("unexpected character '") + source[pos] + "'");
+    pos = end - source.data();
+    height = 1;
+    return makeExpression<NumberExpression>(arena, value);
+  }
+  ExpressionPtr parseExpression(size_t &height)
+  {
+    ExpressionPtr result = parseOperand(height);
+    for (;;)
     {
-      result = make_unique<SubtractExpression>(move(result), move(terms[i + 1]));
+      skipSpaces();
+      if (atLineEnd() || (source[pos] != '+' && source[pos] != '-'))
+        return result;
+      if (height >= maxTreeDepth)
+        fail("expression more than " + to_string(maxTreeDepth) + " levels deep");
+      char op = source[pos++];
+      size_t rightHeight = 0;
+      ExpressionPtr right = parseOperand(rightHeight);
+      height = max(height, rightHeight) + 1;
+      if (op == '+')
+        result = makeExpression<AddExpression>(arena, move(result), move(right));
+      else
+        result = makeExpression<SubtractExpression>(arena, move(result), move(right));
     }
   }
+
+public:
+  Parser(string_view src, ExpressionArena *a, Variables *v)
+      : source(src), pos(0), line(1), lineStart(0), arena(a), variables(v) {}
+
+  [[noreturn]] void fail(const string &message) const
+  {
+    throw ParseError(message, pos, line, pos - lineStart + 1);
+  }
+  bool done()
+  {
+    while (pos < source.size() && (source[pos] == '\n' || source[pos] == ' ' || source[pos] == '\t' || source[pos] == '\r'))
+    {
+      if (source[pos++] == '\n')
+      {
+        ++line;
+        lineStart = pos;
+      }
+    }
+    return pos == source.size();
+  }
+  // Parses one expression that must fill the rest of the current line
+  ExpressionPtr parseLine()
+  {
+    size_t height = 0;
+    ExpressionPtr result = parseExpression(height);
+    skipSpaces();
+    if (!atLineEnd())
+      fail(source[pos] == ')' ? "unmatched ')'" : string("expected '+' or '-' but found '") + source[pos] + "'");
+    return result;
+  }
+};
+
+// Parser for simple expressions like "5 + 3 - 2" or "10 - (4 + 2)"
+// Nodes come from the heap, or from the given arena when one is passed. Variable names are
+// allowed only with a symbol table, which assigns them columns. Throws ParseError.
+ExpressionPtr parse(string_view expr, ExpressionArena *arena = nullptr, Variables *variables = nullptr)
+{
+  Parser parser(expr, arena, variables);
+  if (parser.done())
+    parser.fail("empty expression");
+  ExpressionPtr result = parser.parseLine();
+  if (!parser.done())
+    parser.fail("expected a single expression");
   return result;
 }
 
+// Parses a newline-separated buffer in one pass; blank lines are skipped
+vector<ExpressionPtr> parseMany(string_view buffer, ExpressionArena *arena = nullptr, Variables *variables = nullptr)
+{
+  vector<ExpressionPtr> expressions;
+  Parser parser(buffer, arena, variables);
+  while (!parser.done())
+  {
+    expressions.push_back(parser.parseLine());
+  }
+  return expressions;
+}
+
+// Compiled form of an expression: postfix bytecode run by a flat loop
+class CompiledExpression
+{
+  vector<Instruction> code;
+  size_t maxDepth = 1;
+  size_t columnCount = 0; // Row width the program reads
+  mutable vector<int> stack; // Scratch stacks, sized at compile time (not thread-safe)
+  mutable vector<int> blockStack;
+
+public:
+  static constexpr size_t blockRows = 1024; // Rows per column block in evaluateBatch, sized to stay in L1
+
+  explicit CompiledExpression(vector<Instruction> c) : code(move(c))
+  {
+    size_t depth = 0;
+    for (const auto &ins : code)
+    {
+      if (ins.op == OpCode::Push || ins.op == OpCode::Load)
+        maxDepth = max(maxDepth, ++depth);
+      else if (ins.op == OpCode::Add || ins.op == OpCode::Subtract)
+        --depth;
+      if (ins.op == OpCode::Load)
+        columnCount = max(columnCount, size_t(ins.operand) + 1);
+    }
+    stack.resize(maxDepth);
+  }
+  int evaluate(Row row = Row()) const
+  {
+    if (row.size() < columnCount)
+      throw out_of_range("CompiledExpression::evaluate: row has fewer columns than the expression reads");
+    int *top = stack.data() - 1;
+    for (const Instruction &ins : code)
+    {
+      switch (ins.op)
+      {
+      case OpCode::Push:
+        *++top = ins.operand;
+        break;
+      case OpCode::Load:
+        *++top = row[ins.operand];
+        break;
+      case OpCode::Add:
+        top[-1] += top[0];
+        --top;
+        break;
+      case OpCode::Subtract:
+        top[-1] -= top[0];
+        --top;
+        break;
+      case OpCode::AddConst:
+        *top += ins.operand;
+        break;
+      case OpCode::SubtractConst:
+        *top -= ins.operand;
+        break;
+      }
+    }
+    return *top;
+  }
+  // Evaluates every row: columns[c] holds variable c for all rows, results go to out.
+  // Each instruction runs over a whole block of rows, so every operator is a plain vectorizable loop.
+  void evaluateBatch(span<const Row> columns, span<int> out) const
+  {
+    if (columns.size() < columnCount)
+      throw out_of_range("CompiledExpression::evaluateBatch: fewer columns than the expression reads");
+    for (size_t c = 0; c < columnCount; ++c)
+    {
+      if (columns[c].size() < out.size())
+        throw out_of_range("CompiledExpression::evaluateBatch: column shorter than the output");
+    }
+    blockStack.resize(maxDepth * blockRows);
+    for (size_t first = 0; first < out.size(); first += blockRows)
+    {
+      const size_t n = min(blockRows, out.size() - first);
+      int *top = blockStack.data() - blockRows;
+      for (const Instruction &ins : code)
+      {
+        switch (ins.op)
+        {
+        case OpCode::Push:
+          top += blockRows;
+          fill(top, top + n, ins.operand);
+          break;
+        case OpCode::Load:
+          top += blockRows;
+          copy_n(columns[ins.operand].data() + first, n, top);
+          break;
+        case OpCode::Add:
+          addColumns(top - blockRows, top, n);
+          top -= blockRows;
+          break;
+        case OpCode::Subtract:
+          subtractColumns(top - blockRows, top, n);
+          top -= blockRows;
+          break;
+        case OpCode::AddConst:
+          addConstant(top, ins.operand, n);
+          break;
+        case OpCode::SubtractConst:
+          subtractConstant(top, ins.operand, n);
+          break;
+        }
+      }
+      copy_n(top, n, out.data() + first);
+    }
+  }
+  size_t size() const { return code.size(); }
+  size_t columns() const { return columnCount; }
+
+private:
+  static void addColumns(int *__restrict a, const int *__restrict b, size_t n)
+  {
+    for (size_t i = 0; i < n; ++i)
+      a[i] += b[i];
+  }
+  static void subtractColumns(int *__restrict a, const int *__restrict b, size_t n)
+  {
+    for (size_t i = 0; i < n; ++i)
+      a[i] -= b[i];
+  }
+  static void addConstant(int *a, int k, size_t n)
+  {
+    for (size_t i = 0; i < n; ++i)
+      a[i] += k;
+  }
+  // Not addConstant(-k): negating INT_MIN overflows
+  static void subtractConstant(int *a, int k, size_t n)
+  {
+    for (size_t i = 0; i < n; ++i)
+      a[i] -= k;
+  }
+};
+
+CompiledExpression compile(const Expression &expr)
+{
+  vector<Instruction> code;
+  expr.emit(code);
+  return CompiledExpression(move(code));
+}
+
+// Batch evaluation of one expression over columns of variable bindings
+void evaluateBatch(const Expression &expr, span<const Row> columns, span<int> out)
+{
+  compile(expr).evaluateBatch(columns, out);
+}
+
+// How much optimize() shrank a tree
+struct OptimizationReport
+{
+  size_t nodesBefore;     // Nodes in the source tree
+  size_t nodesAfter;      // Nodes in the optimized DAG
+  size_t constantsFolded; // Arithmetic done at optimization time
+  size_t sharedSubtrees;  // Subtrees replaced by an identical existing node
+};
+
+// Result of optimize(): the folded, hash-consed DAG plus the values of its nodes from the last
+// evaluation. evaluate() recomputes only the nodes that depend on columns whose values changed.
+class OptimizedExpression
+{
+  using Kind = ExpressionGraph::Kind;
+  using Node = ExpressionGraph::Node;
+
+  vector<Node> nodes; // Topologically ordered, root last
+  vector<uint64_t> columnMasks; // Columns each node depends on (columns < 64)
+  size_t columnCount = 0;
+  OptimizationReport summary;
+  mutable vector<int> values; // Cached results, not thread-safe
+  mutable vector<int> lastRow;
+  mutable bool primed = false;
+
+  void compute(size_t id) const
+  {
+    const Node &n = nodes[id];
+    switch (n.kind)
+    {
+    case Kind::Constant:
+      values[id] = n.value;
+      break;
+    case Kind::Variable:
+      values[id] = lastRow[n.value];
+      break;
+    case Kind::Add:
+      values[id] = ExpressionGraph::wrapAdd(values[n.left], values[n.right]);
+      break;
+    case Kind::Subtract:
+      values[id] = ExpressionGraph::wrapSubtract(values[n.left], values[n.right]);
+      break;
+    }
+  }
+
+public:
+  OptimizedExpression(const ExpressionGraph &graph, uint32_t root)
+  {
+    // Keep only nodes reachable from the root; folding leaves intermediate nodes behind
+    const auto &all = graph.getNodes();
+    vector<uint32_t> remap(all.size(), UINT32_MAX);
+    vector<bool> reachable(all.size(), false);
+    reachable[root] = true;
+    for (size_t i = root + 1; i-- > 0;)
+    {
+      if (reachable[i] && (all[i].kind == Kind::Add || all[i].kind == Kind::Subtract))
+        reachable[all[i].left] = reachable[all[i].right] = true;
+    }
+    for (size_t i = 0; i <= root; ++i)
+    {
+      if (!reachable[i])
+        continue;
+      Node n = all[i];
+      if (n.kind == Kind::Add || n.kind == Kind::Subtract)
+      {
+        n.left = remap[n.left];
+        n.right = remap[n.right];
+      }
+      remap[i] = uint32_t(nodes.size());
+      nodes.push_back(n);
+    }
+    columnMasks.resize(nodes.size(), 0);
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+      const Node &n = nodes[i];
+      if (n.kind == Kind::Variable)
+      {
+        columnCount = max(columnCount, size_t(n.value) + 1);
+        columnMasks[i] = n.value < 64 ? uint64_t(1) << n.value : ~uint64_t(0);
+      }
+      else if (n.kind != Kind::Constant)
+        columnMasks[i] = columnMasks[n.left] | columnMasks[n.right];
+    }
+    values.resize(nodes.size());
+    summary = {graph.sourceNodes, nodes.size(), graph.constantsFolded, graph.sharedSubtrees};
+  }
+
+  int evaluate(Row row = Row()) const
+  {
+    if (row.size() < columnCount)
+      throw out_of_range("OptimizedExpression::evaluate: row has fewer columns than the expression reads");
+    uint64_t changed = 0;
+    if (!primed)
+    {
+      lastRow.assign(row.begin(), row.begin() + columnCount);
+      changed = ~uint64_t(0);
+      primed = true;
+    }
+    for (size_t c = 0; c < columnCount; ++c)
+    {
+      if (row[c] != lastRow[c])
+      {
+        lastRow[c] = row[c];
+        changed |= c < 64 ? uint64_t(1) << c : ~uint64_t(0);
+      }
+    }
+    if (changed == ~uint64_t(0))
+    {
+      for (size_t i = 0; i < nodes.size(); ++i)
+        compute(i);
+    }
+    else if (changed)
+    {
+      for (size_t i = 0; i < nodes.size(); ++i)
+      {
+        if (columnMasks[i] & changed)
+          compute(i);
+      }
+    }
+    return values.back();
+  }
+  const OptimizationReport &report() const { return summary; }
+};
+
+OptimizedExpression optimize(const Expression &expr)
+{
+  ExpressionGraph graph;
+  uint32_t root = expr.lower(graph);
+  return OptimizedExpression(graph, root);
+}
+
+#ifndef DESIGN_PATTERNS_NO_MAIN
 int main()
 {
   string expr1 = "5 + 3 - 2";
@@ -124,5 +841,59 @@ int main()
   auto tree2 = parse(expr2);
   cout << "Result: " << tree2->interpret() << endl;
 
+  ExpressionArena arena;
+  auto tree3 = parse("7 - 2 + 10 - 1", &arena);
+  CompiledExpression program = compile(*tree3);
+  cout << "\nExpression: 7 - 2 + 10 - 1 (arena-allocated, compiled to " << program.size() << " instructions)" << endl;
+  cout << "Result: " << tree3->interpret() << " (tree-walk), " << program.evaluate() << " (bytecode)" << endl;
+
+  cout << "\nParsing a batch of rules:" << endl;
+  for (const auto &rule : parseMany("10 - (4 + 2)\n\n(1 + 2) - (3 - 4)\n-5 + 8\n"))
+  {
+    cout << "Result: " << rule->interpret() << endl;
+  }
+
+  Variables variables;
+  auto score = parse("price - discount + 5", nullptr, &variables);
+  vector<int> prices = {100, 250, 80}, discounts = {10, 50, 0}, scores(3);
+  vector<Row> columns = {prices, discounts};
+  evaluateBatch(*score, columns, scores);
+  cout << "\nRule: price - discount + 5 over 3 rows" << endl;
+  for (size_t r = 0; r < scores.size(); ++r)
+  {
+    cout << "Row " << r << ": " << scores[r] << " (interpret: " << score->interpret(vector<int>{prices[r], discounts[r]}) << ")" << endl;
+  }
+
+  auto folded = parse("(price + 2) + 3 - (discount - discount) + (1 - 1)", nullptr, &variables);
+  OptimizedExpression optimized = optimize(*folded);
+  cout << "\nOptimized (price + 2) + 3 - (discount - discount) + (1 - 1): " << optimized.report().nodesBefore
+       << " -> " << optimized.report().nodesAfter << " nodes, result " << optimized.evaluate(vector<int>{100, 10}) << endl;
+
+  try
+  {
+    parse("5 + * 3");
+  }
+  catch (const ParseError &e)
+  {
+    cout << "\nParse error: " << e.what() << endl;
+  }
+
+  // A flat chain is as deep as it is long: the deepest allowed one evaluates, one term more is rejected
+  string chain = "1";
+  for (size_t i = 1; i < Parser::maxTreeDepth; ++i)
+  {
+    chain += " + 1";
+  }
+  cout << "\nChain of " << Parser::maxTreeDepth << " ones: " << parse(chain)->interpret() << endl;
+  try
+  {
+    parse(chain + " + 1");
+  }
+  catch (const ParseError &e)
+  {
+    cout << "Parse error: " << e.what() << endl;
+  }
+
   return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -15,12 +15,22 @@ How it works in this example:
 - The client uses the iterator to traverse the shopping list without knowing its internal structure.
 
 This pattern is especially useful when you want to provide multiple ways to traverse a collection, or when you want to hide the internal structure of the collection from the client.
+
+Contiguous and batched traversal:
+- ShoppingList also exposes its items as a standard contiguous range (begin()/end(), view() as a
+  std::span<const std::string>), so a range-for over the list compiles to pointer increments with no virtual calls.
+- Iterator::nextBatch(n) returns up to n items as a span, so a polymorphic traversal pays one virtual call per
+  chunk instead of one per item. The default implementation copies items from next() into a buffer, which keeps
+  iterators of non-contiguous aggregates working; ShoppingListIterator overrides it with a view into the list.
+- Spans returned by view() and nextBatch() are invalidated by adding items to the list.
 */
 
 #include <iostream>
 #include <vector>
 #include <string>
 #include <memory>
+#include <span>
+#include <algorithm>
 
 // Iterator interface
 class Iterator
@@ -28,7 +38,21 @@ class Iterator
 public:
   virtual ~Iterator() = default;
   virtual bool hasNext() const = 0;
+  // Precondition: hasNext()
   virtual const std::string &next() = 0;
+  // Up to n following items; empty once the traversal is finished
+  virtual std::span<const std::string> nextBatch(size_t n)
+  {
+    batch.clear();
+    while (batch.size() < n && hasNext())
+    {
+      batch.push_back(next());
+    }
+    return batch;
+  }
+
+private:
+  std::vector<std::string> batch; // storage for the default nextBatch()
 };
 
 // Aggregate interface
@@ -51,6 +75,9 @@ public:
   }
   size_t size() const { return items.size(); }
   const std::string &getItem(size_t index) const { return items.at(index); }
+  std::vector<std::string>::const_iterator begin() const { return items.begin(); }
+  std::vector<std::string>::const_iterator end() const { return items.end(); }
+  std::span<const std::string> view() const { return items; }
   std::unique_ptr<Iterator> createIterator() const override;
 };
 
@@ -68,7 +95,15 @@ public:
   }
   const std::string &next() override
   {
-    return shoppingList.getItem(index++);
+    return shoppingList.view()[index++];
+  }
+  std::span<const std::string> nextBatch(size_t n) override
+  {
+    std::span<const std::string> all = shoppingList.view();
+    size_t count = std::min(n, all.size() - index);
+    std::span<const std::string> batch = all.subspan(index, count);
+    index += count;
+    return batch;
   }
 };
 
@@ -77,6 +112,7 @@ std::unique_ptr<Iterator> ShoppingList::createIterator() const
   return std::make_unique<ShoppingListIterator>(*this);
 }
 
+#ifndef DESIGN_PATTERNS_NO_MAIN
 // Demo
 int main()
 {
@@ -92,5 +128,18 @@ int main()
   {
     std::cout << "- " << it->next() << std::endl;
   }
+
+  std::cout << "\nRange-for over the list:";
+  for (const auto &item : list)
+  {
+    std::cout << " " << item;
+  }
+  std::cout << "\n\nIn batches of 3:\n";
+  it = list.createIterator();
+  for (auto batch = it->nextBatch(3); !batch.empty(); batch = it->nextBatch(3))
+  {
+    std::cout << "- batch of " << batch.size() << ": " << batch.front() << " .. " << batch.back() << std::endl;
+  }
   return 0;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -23,21 +23,49 @@ We will model a blog system where:
 - The Blog can notify all posts of certain events (e.g., a new post is published, or a post is updated).
 - BlogPosts do not communicate directly with each other, but only through the Blog (mediator).
 
+Topic-Indexed Dispatch:
+-----------------------
+Broadcasting every event to every post costs O(posts x events) with a string compare per call.
+- Event names are interned into integer `EventId`s once; posts look theirs up when they get a mediator.
+- Each event id keeps its own subscriber list, so `notify` touches only the posts that subscribed.
+  `registerPost(post)` still subscribes a post to every event; `subscribe(post, event)` is the narrow form.
+  Each post gets an event at most once: subscribing a post that already hears every event does nothing.
+- `startDispatcher()` makes `notify` enqueue instead; a mediator thread drains the queue in batches,
+  one lock per batch. Register, subscribe and intern every event name before starting it: the tables are
+  read without a lock while it runs, so changing them throws `logic_error` until `stopDispatcher()` has
+  drained the queue and joined the thread. `flush()` waits for delivery.
+- Notifications/sec by number of posts is measured in bench/mediator.cpp.
+
 */
 
 #include <iostream>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <initializer_list>
+#include <algorithm>
+#include <stdexcept>
 using namespace std;
 
 // Forward declaration
 class BlogPost;
 
+using EventId = uint32_t;
+
 // Mediator interface
 class BlogMediator
 {
 public:
   virtual void notify(BlogPost *sender, const string &event) = 0;
+  virtual void notify(BlogPost *sender, EventId event) = 0;
+  virtual EventId internEvent(string_view name) = 0;
   virtual void registerPost(BlogPost *post) = 0;
   virtual ~BlogMediator() {}
 };
@@ -47,27 +75,35 @@ class BlogPost
 {
   string title;
   string content;
-  BlogMediator *mediator;
+  BlogMediator *mediator = nullptr;
+  EventId publishEvent = 0;
+  EventId updateEvent = 0;
 
 public:
   BlogPost(const string &t, const string &c, BlogMediator *m = nullptr)
-      : title(t), content(c), mediator(m) {}
+      : title(t), content(c)
+  {
+    if (m)
+      setMediator(m);
+  }
   void setMediator(BlogMediator *m)
   {
     mediator = m;
+    publishEvent = m->internEvent("publish");
+    updateEvent = m->internEvent("update");
   }
   void publish()
   {
     cout << "Publishing post: '" << title << "'" << endl;
     if (mediator)
-      mediator->notify(this, "publish");
+      mediator->notify(this, publishEvent);
   }
   void updateContent(const string &newContent)
   {
     content = newContent;
     cout << "Updating post: '" << title << "'" << endl;
     if (mediator)
-      mediator->notify(this, "update");
+      mediator->notify(this, updateEvent);
   }
   string getTitle() const { return title; }
   string getContent() const { return content; }
@@ -80,26 +116,207 @@ public:
   }
 };
 
+// Lets the event table be searched with a string_view without building a string
+struct EventNameHash
+{
+  using is_transparent = void;
+  size_t operator()(string_view name) const { return hash<string_view>{}(name); }
+};
+
 // Concrete Mediator: Blog
 class Blog : public BlogMediator
 {
-  vector<BlogPost *> posts;
+  struct Notification
+  {
+    BlogPost *sender;
+    EventId event;
+  };
+
+  unordered_map<string, EventId, EventNameHash, equal_to<>> eventIds;
+  vector<string> eventNames;
+  vector<vector<BlogPost *>> subscribers; // indexed by EventId
+  vector<BlogPost *> allEvents;           // posts registered without a topic list
+
+  // Queued mode
+  mutex queueLock;
+  condition_variable queueChanged;
+  vector<Notification> queue;
+  atomic<bool> dispatching{false}; // cleared only once the dispatcher thread has been joined
+  bool stopping = false;
+  bool dispatcherExited = false; // the thread drained its last batch; stopDispatcher() has yet to clear dispatching
+  size_t inFlight = 0;
+  thread dispatcher;
+
+  // The dispatcher thread reads the event tables unlocked, so they are frozen while it runs
+  void checkNotDispatching(const char *what) const
+  {
+    if (dispatching.load())
+      throw logic_error(string("Blog::") + what + ": the event tables cannot change while the dispatcher runs");
+  }
+
+  void dispatch(BlogPost *sender, EventId event)
+  {
+    const string &name = eventNames[event];
+    for (auto *post : subscribers[event])
+    {
+      post->notifyEvent(name, sender);
+    }
+    for (auto *post : allEvents)
+    {
+      post->notifyEvent(name, sender);
+    }
+  }
+
+  void drainLoop()
+  {
+    vector<Notification> batch;
+    unique_lock<mutex> guard(queueLock);
+    for (;;)
+    {
+      queueChanged.wait(guard, [this]()
+                        { return stopping || !queue.empty(); });
+      if (queue.empty())
+      {
+        dispatcherExited = true;
+        return;
+      }
+      batch.swap(queue);
+      inFlight = batch.size();
+      guard.unlock();
+      for (const auto &n : batch)
+      {
+        dispatch(n.sender, n.event);
+      }
+      batch.clear();
+      guard.lock();
+      inFlight = 0;
+      queueChanged.notify_all();
+    }
+  }
 
 public:
+  ~Blog()
+  {
+    stopDispatcher();
+  }
+
+  EventId internEvent(string_view name) override
+  {
+    auto it = eventIds.find(name);
+    if (it != eventIds.end())
+      return it->second;
+    checkNotDispatching("internEvent");
+    EventId id = EventId(eventNames.size());
+    eventNames.emplace_back(name);
+    subscribers.emplace_back();
+    eventIds.emplace(eventNames.back(), id);
+    return id;
+  }
+  const string &eventName(EventId event) const
+  {
+    return eventNames[event];
+  }
+
+  // Subscribes the post to every event, replacing any per-event subscriptions it had
   void registerPost(BlogPost *post) override
   {
-    posts.push_back(post);
+    checkNotDispatching("registerPost");
+    post->setMediator(this);
+    if (find(allEvents.begin(), allEvents.end(), post) != allEvents.end())
+      return;
+    for (auto &list : subscribers)
+    {
+      list.erase(remove(list.begin(), list.end(), post), list.end());
+    }
+    allEvents.push_back(post);
+  }
+  // Registers the post for the given events only
+  void registerPost(BlogPost *post, initializer_list<string_view> events)
+  {
+    checkNotDispatching("registerPost");
     post->setMediator(this);
+    for (string_view event : events)
+    {
+      subscribe(post, internEvent(event));
+    }
+  }
+  // No-op if the post already receives the event
+  void subscribe(BlogPost *post, EventId event)
+  {
+    checkNotDispatching("subscribe");
+    auto &list = subscribers.at(event);
+    if (find(allEvents.begin(), allEvents.end(), post) != allEvents.end() ||
+        find(list.begin(), list.end(), post) != list.end())
+      return;
+    list.push_back(post);
+  }
+  size_t subscriberCount(EventId event) const
+  {
+    return subscribers[event].size() + allEvents.size();
   }
+
   void notify(BlogPost *sender, const string &event) override
   {
-    for (auto *post : posts)
+    notify(sender, internEvent(event));
+  }
+  void notify(BlogPost *sender, EventId event) override
+  {
+    if (dispatching.load(memory_order_acquire))
     {
-      post->notifyEvent(event, sender);
+      unique_lock<mutex> guard(queueLock);
+      if (dispatching && !dispatcherExited)
+      {
+        queue.push_back({sender, event});
+        if (queue.size() == 1)
+          queueChanged.notify_all();
+        return;
+      }
+      // The dispatcher is shutting down: deliver inline once it is gone, after everything it drained
+      queueChanged.wait(guard, [this]()
+                        { return !dispatching; });
     }
+    dispatch(sender, event);
+  }
+
+  // From now on notify() only enqueues; the mediator thread delivers in batches
+  void startDispatcher()
+  {
+    lock_guard<mutex> guard(queueLock);
+    if (dispatching)
+      return;
+    dispatching = true;
+    stopping = false;
+    dispatcherExited = false;
+    dispatcher = thread(&Blog::drainLoop, this);
+  }
+  // Delivers what is queued, then goes back to delivering on the caller's thread. The event tables stay
+  // frozen until the dispatcher thread has been joined.
+  void stopDispatcher()
+  {
+    {
+      lock_guard<mutex> guard(queueLock);
+      if (!dispatching || stopping)
+        return;
+      stopping = true;
+    }
+    queueChanged.notify_all();
+    dispatcher.join();
+    {
+      lock_guard<mutex> guard(queueLock);
+      dispatching = false;
+    }
+    queueChanged.notify_all();
+  }
+  // Blocks until every queued notification has been delivered
+  void flush()
+  {
+    unique_lock<mutex> guard(queueLock);
+    queueChanged.wait(guard, [this]()
+                      { return queue.empty() && inFlight == 0; });
   }
 };
 
+#ifndef DESIGN_PATTERNS_NO_MAIN
 int main()
 {
   Blog blog;
@@ -117,5 +334,21 @@ int main()
   cout << endl;
   post3.publish();
 
+  // Topic subscription: post4 only hears about updates
+  BlogPost post4("Digest", "Weekly list of changed posts");
+  blog.registerPost(&post4, {"update"});
+  cout << endl;
+  post1.updateContent("Observer pattern, revised");
+  cout << endl;
+  post2.publish();
+
+  // Queued mode: notifications are delivered by the mediator thread
+  cout << "\nQueued dispatch:" << endl;
+  blog.startDispatcher();
+  post3.updateContent("Strategy pattern, revised");
+  blog.flush();
+  blog.stopDispatcher();
+
   return 0;
 }
+#endif
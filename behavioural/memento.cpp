@@ -1,6 +1,21 @@
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <memory>
+#include <algorithm>
+#include <unordered_set>
+#include <stdexcept>
+#include <system_error>
+#include <filesystem>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 /*
 Memento Design Pattern (C++)
@@ -18,6 +33,24 @@ How it works in this example:
 - The Caretaker class keeps a list of Mementos, allowing the user to save and restore previous states, and to display the history of saved states.
 
 This pattern is especially useful when you want to provide undo/redo functionality or maintain a history of changes without violating encapsulation.
+
+Chunked Copy-on-Write Snapshots:
+- DocumentOriginator keeps a large state as a list of refcounted chunks (64 KB by default).
+- A DocumentMemento is just the list of chunk pointers, so saving shares every chunk with the document.
+- The document copies a chunk only when it edits one that a memento still references, so each new
+  snapshot costs the chunks changed since the last one plus one pointer per chunk.
+- Restoring copies the pointer list; chunk data is copied again only when it is next edited.
+- Snapshot size and time for 1000 snapshots of a 10 MB state are measured in bench/memento.cpp.
+
+Persistent History:
+- FileCaretaker appends mementos to segment files in a directory and writes one fixed-size index
+  record (segment, offset, length, short preview) per memento. The length is 32-bit, so addMemento()
+  rejects states of 4 GiB or more with `length_error` before writing anything.
+- Opening a history only checks the index file size; segments and the index are memory-mapped on
+  first use, so restoring entry N reads only entry N.
+- showHistory() streams the previews from the index without reading any states.
+- A crash between the data write and the index write leaves an unindexed tail that the next open trims.
+- Startup and restore latency for 1M entries are measured in bench/memento.cpp.
 */
 
 // Memento class
@@ -27,7 +60,7 @@ class Memento
 
 public:
   Memento(const std::string &s) : state(s) {}
-  std::string getState() const { return state; }
+  const std::string &getState() const { return state; }
 };
 
 // Originator class
@@ -37,19 +70,177 @@ class Originator
 
 public:
   void setState(const std::string &s) { state = s; }
-  std::string getState() const { return state; }
+  const std::string &getState() const { return state; }
   Memento saveToMemento() const { return Memento(state); }
   void restoreFromMemento(const Memento &m) { state = m.getState(); }
 };
 
+// Snapshot of a DocumentOriginator: shared, immutable chunks
+class DocumentMemento
+{
+  friend class DocumentOriginator;
+  std::vector<std::shared_ptr<std::string>> chunks;
+  size_t length = 0;
+
+public:
+  size_t size() const { return length; }
+  size_t chunkCount() const { return chunks.size(); }
+  std::string getState() const
+  {
+    std::string state;
+    state.reserve(length);
+    for (const auto &chunk : chunks)
+    {
+      state += *chunk;
+    }
+    return state;
+  }
+  // Bytes this snapshot holds that `previous` does not: the changed chunks plus its pointer list
+  size_t bytesNotIn(const DocumentMemento &previous) const
+  {
+    std::unordered_set<const std::string *> shared;
+    for (const auto &chunk : previous.chunks)
+    {
+      shared.insert(chunk.get());
+    }
+    size_t bytes = chunks.size() * sizeof(chunks[0]);
+    for (const auto &chunk : chunks)
+    {
+      if (!shared.count(chunk.get()))
+        bytes += chunk->size();
+    }
+    return bytes;
+  }
+};
+
+// Originator for large states: chunked, copy-on-write against its mementos
+class DocumentOriginator
+{
+  std::vector<std::shared_ptr<std::string>> chunks;
+  std::vector<size_t> starts; // offset of each chunk
+  size_t length = 0;
+  size_t chunkSize;
+
+  void reindex(size_t from)
+  {
+    starts.resize(chunks.size());
+    size_t offset = from == 0 ? 0 : starts[from - 1] + chunks[from - 1]->size();
+    for (size_t i = from; i < chunks.size(); ++i)
+    {
+      starts[i] = offset;
+      offset += chunks[i]->size();
+    }
+    length = offset;
+  }
+
+  // Chunk holding pos; pos == size() maps to the end of the last chunk
+  size_t chunkAt(size_t pos) const
+  {
+    size_t i = size_t(std::upper_bound(starts.begin(), starts.end(), pos) - starts.begin());
+    return i == 0 ? 0 : i - 1;
+  }
+
+  std::string &writable(size_t i)
+  {
+    if (chunks[i].use_count() > 1)
+      chunks[i] = std::make_shared<std::string>(*chunks[i]);
+    return *chunks[i];
+  }
+
+public:
+  explicit DocumentOriginator(size_t chunkBytes = 64 * 1024) : chunkSize(std::max<size_t>(chunkBytes, 1))
+  {
+    setState("");
+  }
+
+  void setState(std::string_view s)
+  {
+    chunks.clear();
+    for (size_t pos = 0; pos < s.size(); pos += chunkSize)
+    {
+      chunks.push_back(std::make_shared<std::string>(s.substr(pos, chunkSize)));
+    }
+    if (chunks.empty())
+      chunks.push_back(std::make_shared<std::string>());
+    reindex(0);
+  }
+  std::string getState() const
+  {
+    std::string state;
+    state.reserve(length);
+    for (const auto &chunk : chunks)
+    {
+      state += *chunk;
+    }
+    return state;
+  }
+  size_t size() const { return length; }
+  char at(size_t pos) const
+  {
+    size_t i = chunkAt(pos);
+    return chunks[i]->at(pos - starts[i]);
+  }
+
+  // Replaces `count` characters at pos with text; only the chunks touched are copied
+  void replace(size_t pos, size_t count, std::string_view text)
+  {
+    if (pos > length)
+      throw std::out_of_range("DocumentOriginator::replace: position past the end");
+    count = std::min(count, length - pos);
+    size_t first = chunkAt(pos);
+    size_t local = pos - starts[first];
+    std::string &target = writable(first);
+    size_t erased = std::min(count, target.size() - local);
+    target.replace(local, erased, text);
+    count -= erased;
+    // Later chunks: drop the fully covered ones without copying them, trim the last one
+    size_t next = first + 1;
+    while (count > 0 && count >= chunks[next]->size())
+    {
+      count -= chunks[next]->size();
+      chunks.erase(chunks.begin() + next);
+    }
+    if (count > 0)
+      writable(next).erase(0, count);
+    if (target.size() >= 2 * chunkSize)
+    {
+      std::vector<std::shared_ptr<std::string>> pieces;
+      for (size_t p = 0; p < target.size(); p += chunkSize)
+      {
+        pieces.push_back(std::make_shared<std::string>(target.substr(p, chunkSize)));
+      }
+      chunks.erase(chunks.begin() + first);
+      chunks.insert(chunks.begin() + first, pieces.begin(), pieces.end());
+    }
+    else if (target.empty() && chunks.size() > 1)
+      chunks.erase(chunks.begin() + first);
+    reindex(first);
+  }
+
+  DocumentMemento saveToMemento() const
+  {
+    DocumentMemento m;
+    m.chunks = chunks;
+    m.length = length;
+    return m;
+  }
+  void restoreFromMemento(const DocumentMemento &m)
+  {
+    chunks = m.chunks;
+    reindex(0);
+  }
+};
+
 // Caretaker class
-class Caretaker
+template <typename M>
+class BasicCaretaker
 {
-  std::vector<Memento> mementos;
+  std::vector<M> mementos;
 
 public:
-  void addMemento(const Memento &m) { mementos.push_back(m); }
-  Memento getMemento(size_t index) const { return mementos.at(index); }
+  void addMemento(M m) { mementos.push_back(std::move(m)); }
+  const M &getMemento(size_t index) const { return mementos.at(index); }
+  size_t size() const { return mementos.size(); }
   void showHistory() const
   {
     std::cout << "History of saved states:" << std::endl;
@@ -60,6 +251,216 @@ public:
   }
 };
 
+using Caretaker = BasicCaretaker<Memento>;
+
+// Read-only mmap of a file, remapped when the file grows past what is mapped
+class MappedFile
+{
+  const char *data = nullptr;
+  size_t mapped = 0;
+
+public:
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile()
+  {
+    if (data)
+      munmap(const_cast<char *>(data), mapped);
+  }
+
+  // Returns the mapped bytes [offset, offset + length), mapping fd again if it has grown
+  std::string_view view(int fd, size_t offset, size_t length)
+  {
+    if (offset + length > mapped)
+    {
+      struct stat info;
+      if (fstat(fd, &info) != 0)
+        throw std::system_error(errno, std::generic_category(), "MappedFile: fstat");
+      size_t size = size_t(info.st_size);
+      if (offset + length > size)
+        throw std::out_of_range("MappedFile: range past the end of the file");
+      void *fresh = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+      if (fresh == MAP_FAILED)
+        throw std::system_error(errno, std::generic_category(), "MappedFile: mmap");
+      if (data)
+        munmap(const_cast<char *>(data), mapped);
+      data = static_cast<const char *>(fresh);
+      mapped = size;
+    }
+    return std::string_view(data + offset, length);
+  }
+};
+
+// Caretaker backed by a segmented append-only log and a fixed-record index in `directory`
+class FileCaretaker
+{
+  struct IndexRecord
+  {
+    uint32_t segment;
+    uint32_t length;
+    uint64_t offset;
+    char preview[16];
+  };
+  static_assert(sizeof(IndexRecord) == 32);
+
+  struct Segment
+  {
+    int fd = -1;
+    MappedFile map;
+  };
+
+  std::filesystem::path directory;
+  uint64_t segmentBytes;
+  int indexFd = -1;
+  size_t count = 0;
+  MappedFile indexMap;
+  std::vector<std::unique_ptr<Segment>> segments;
+  uint32_t activeSegment = 0;
+  uint64_t activeSize = 0;
+
+  static void check(bool ok, const char *what)
+  {
+    if (!ok)
+      throw std::system_error(errno, std::generic_category(), what);
+  }
+
+  std::filesystem::path segmentPath(uint32_t segment) const
+  {
+    char name[32];
+    std::snprintf(name, sizeof(name), "segment-%06u.log", segment);
+    return directory / name;
+  }
+
+  Segment &segment(uint32_t id)
+  {
+    while (segments.size() <= id)
+    {
+      segments.push_back(nullptr);
+    }
+    if (!segments[id])
+    {
+      auto opened = std::make_unique<Segment>();
+      opened->fd = ::open(segmentPath(id).c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+      check(opened->fd >= 0, "FileCaretaker: open segment");
+      segments[id] = std::move(opened);
+    }
+    return *segments[id];
+  }
+
+  void writeAll(int fd, const char *bytes, size_t length, uint64_t offset)
+  {
+    while (length > 0)
+    {
+      ssize_t written = ::pwrite(fd, bytes, length, off_t(offset));
+      if (written < 0 && errno == EINTR)
+        continue;
+      check(written > 0, "FileCaretaker: write");
+      bytes += written;
+      length -= size_t(written);
+      offset += uint64_t(written);
+    }
+  }
+
+  IndexRecord record(size_t index)
+  {
+    if (index >= count)
+      throw std::out_of_range("FileCaretaker: no memento at that index");
+    IndexRecord r;
+    std::memcpy(&r, indexMap.view(indexFd, index * sizeof(IndexRecord), sizeof(IndexRecord)).data(), sizeof(r));
+    return r;
+  }
+
+public:
+  explicit FileCaretaker(const std::filesystem::path &dir, uint64_t segmentSize = 64 << 20)
+      : directory(dir), segmentBytes(segmentSize)
+  {
+    std::filesystem::create_directories(directory);
+    indexFd = ::open((directory / "index.bin").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    check(indexFd >= 0, "FileCaretaker: open index");
+    struct stat info;
+    check(fstat(indexFd, &info) == 0, "FileCaretaker: fstat index");
+    count = size_t(info.st_size) / sizeof(IndexRecord);
+    // Drop a torn index record and any segment bytes written after the last indexed memento
+    check(ftruncate(indexFd, off_t(count * sizeof(IndexRecord))) == 0, "FileCaretaker: trim index");
+    if (count > 0)
+    {
+      IndexRecord last = record(count - 1);
+      activeSegment = last.segment;
+      activeSize = last.offset + last.length;
+      check(ftruncate(segment(activeSegment).fd, off_t(activeSize)) == 0, "FileCaretaker: trim segment");
+    }
+  }
+  ~FileCaretaker()
+  {
+    for (auto &s : segments)
+    {
+      if (s)
+        ::close(s->fd);
+    }
+    if (indexFd >= 0)
+      ::close(indexFd);
+  }
+  FileCaretaker(const FileCaretaker &) = delete;
+  FileCaretaker &operator=(const FileCaretaker &) = delete;
+
+  size_t size() const { return count; }
+
+  void addMemento(const Memento &m)
+  {
+    const std::string &state = m.getState();
+    if (state.size() > UINT32_MAX)
+      throw std::length_error("FileCaretaker: states of 4 GiB or more do not fit an index record");
+    if (activeSize > 0 && activeSize + state.size() > segmentBytes)
+    {
+      ++activeSegment;
+      activeSize = 0;
+    }
+    writeAll(segment(activeSegment).fd, state.data(), state.size(), activeSize);
+    IndexRecord r{activeSegment, uint32_t(state.size()), activeSize, {}};
+    std::memcpy(r.preview, state.data(), std::min(state.size(), sizeof(r.preview)));
+    writeAll(indexFd, reinterpret_cast<const char *>(&r), sizeof(r), count * sizeof(IndexRecord));
+    activeSize += state.size();
+    ++count;
+  }
+
+  // Zero-copy view of a saved state; valid until the next call on this caretaker
+  std::string_view viewState(size_t index)
+  {
+    IndexRecord r = record(index);
+    Segment &s = segment(r.segment);
+    return s.map.view(s.fd, r.offset, r.length);
+  }
+  Memento getMemento(size_t index)
+  {
+    return Memento(std::string(viewState(index)));
+  }
+
+  void showHistory(std::ostream &out = std::cout)
+  {
+    out << "History of saved states:" << std::endl;
+    for (size_t i = 0; i < count; ++i)
+    {
+      IndexRecord r = record(i);
+      std::string_view preview(r.preview, std::min<size_t>(r.length, sizeof(r.preview)));
+      out << i << ": " << preview << (r.length > sizeof(r.preview) ? "..." : "") << " (" << r.length
+          << " bytes, segment " << r.segment << ")" << std::endl;
+    }
+  }
+
+  // Flushes the log and index to disk
+  void sync()
+  {
+    for (auto &s : segments)
+    {
+      if (s)
+        check(fdatasync(s->fd) == 0, "FileCaretaker: sync segment");
+    }
+    check(fdatasync(indexFd) == 0, "FileCaretaker: sync index");
+  }
+};
+
+#ifndef DESIGN_PATTERNS_NO_MAIN
 int main()
 {
   Originator originator;
@@ -84,5 +485,34 @@ int main()
   originator.restoreFromMemento(caretaker.getMemento(1));
   std::cout << "Second saved State: " << originator.getState() << std::endl;
 
+  // Chunked copy-on-write snapshots (8-byte chunks so the sharing is visible)
+  DocumentOriginator document(8);
+  BasicCaretaker<DocumentMemento> versions;
+  document.setState("Chapter 1. Chapter 2. Chapter 3.");
+  versions.addMemento(document.saveToMemento());
+  document.replace(11, 9, "Chapter Two");
+  versions.addMemento(document.saveToMemento());
+  std::cout << "\nDocument: " << document.getState() << std::endl;
+  versions.showHistory();
+  std::cout << "Bytes added by snapshot 1: " << versions.getMemento(1).bytesNotIn(versions.getMemento(0)) << std::endl;
+  document.restoreFromMemento(versions.getMemento(0));
+  std::cout << "Restored: " << document.getState() << std::endl;
+
+  // Persistent history: reopening the directory finds the saved mementos again
+  std::filesystem::path historyDir = std::filesystem::temp_directory_path() / "memento_demo_history";
+  std::filesystem::remove_all(historyDir);
+  {
+    FileCaretaker onDisk(historyDir);
+    onDisk.addMemento(Memento("State #1"));
+    onDisk.addMemento(Memento("A much longer state that only shows a preview"));
+  }
+  FileCaretaker reopened(historyDir);
+  std::cout << std::endl;
+  reopened.showHistory();
+  originator.restoreFromMemento(reopened.getMemento(0));
+  std::cout << "Restored from disk: " << originator.getState() << std::endl;
+  std::filesystem::remove_all(historyDir);
+
   return 0;
 }
+#endif
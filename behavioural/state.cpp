@@ -1,23 +1,30 @@
 /*
 State Design Pattern (Document Publishing Example, C++)
 ------------------------------------------------------
-This example demonstrates the State pattern applied to a document publishing workflow. The Document class delegates its publish() behavior to a DocumentState interface, which is implemented by various concrete states (Draft, UnderReview, Published, Archived, etc.). The behavior of publish() depends on both the current state and the user's role (Editor, Moderator, Admin). This design satisfies the Open/Closed Principle: new states or roles can be added by extending classes, not by modifying existing ones.
+This example demonstrates the State pattern applied to a document publishing workflow. The behavior of publish() depends on both the current state of the document (Draft, UnderReview, Published, Archived) and the user's role (Editor, Moderator, Admin).
 
 Key Participants:
-- Document: The context class, representing a document. It maintains a reference to a DocumentState and delegates state-specific behavior to it.
-- DocumentState (interface): Declares the interface for state-specific behavior (publish).
-- Concrete States: Implement state-specific behavior for publish (Draft, UnderReview, Published, Archived, etc.).
+- Document: The context class, representing a document. It holds its current state and delegates publish() to the state machine.
+- DocumentState (enum): The states of the workflow. States carry no data, so an enum value is all a document needs to store.
+- Transition table: A constexpr table indexed by (state, role) giving the next state and the action taken.
 - UserRole (enum): Represents user roles (Editor, Moderator, Admin).
 
 How it works in this example:
-- The Document class has a state and a publish() method, which delegates to the current state's publish() method.
-- Each state implements its own logic for publish(), possibly transitioning the document to a new state depending on the user's role.
-- The design is open for extension (new states/roles) and closed for modification (existing code doesn't need to change).
+- The Document class has a state and a publish() method, which looks up the (state, role) entry in the transition table.
+- Each entry says which state comes next (possibly the same one) and what happened, so new states or roles are added as table rows and columns.
+- A transition is one table lookup: no allocation and no virtual call, and getStateName() returns a string_view into a constant table.
+- publishAll(documents, roles) applies one event per document in bulk without logging; transitions/sec against
+  the original heap-allocated state objects is measured in bench/state.cpp.
 */
 
 #include <iostream>
-#include <memory>
 #include <string>
+#include <string_view>
+#include <array>
+#include <span>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
 
 // User roles
 enum class UserRole
@@ -42,140 +49,97 @@ std::string roleToString(UserRole role)
   }
 }
 
-class Document;
-
-// State interface
-class DocumentState
+// Workflow states
+enum class DocumentState : std::uint8_t
 {
-public:
-  virtual ~DocumentState() = default;
-  virtual void publish(Document &doc, UserRole user) = 0;
-  virtual std::string name() const = 0;
+  Draft,
+  UnderReview,
+  Published,
+  Archived
 };
 
-// Forward declaration for state transitions
-class DraftState;
-class UnderReviewState;
-class PublishedState;
-class ArchivedState;
-
-// Document class
-class Document
-{
-  std::unique_ptr<DocumentState> state;
-  std::string title;
-
-public:
-  Document(std::string t);
-  void setState(std::unique_ptr<DocumentState> newState);
-  void publish(UserRole user);
-  std::string getStateName() const;
-  std::string getTitle() const { return title; }
-};
+constexpr std::size_t stateCount = 4;
+constexpr std::size_t roleCount = 3;
 
-// Concrete States
-class DraftState : public DocumentState
-{
-public:
-  void publish(Document &doc, UserRole user) override;
-  std::string name() const override { return "Draft"; }
-};
+constexpr std::array<std::string_view, stateCount> stateNames{"Draft", "Under Review", "Published", "Archived"};
 
-class UnderReviewState : public DocumentState
+struct Transition
 {
-public:
-  void publish(Document &doc, UserRole user) override;
-  std::string name() const override { return "Under Review"; }
+  DocumentState next;
+  std::string_view action;
 };
 
-class PublishedState : public DocumentState
-{
-public:
-  void publish(Document &doc, UserRole user) override;
-  std::string name() const override { return "Published"; }
-};
-
-class ArchivedState : public DocumentState
-{
-public:
-  void publish(Document &doc, UserRole user) override;
-  std::string name() const override { return "Archived"; }
-};
-
-// Document implementation
-Document::Document(std::string t)
-    : state(std::make_unique<DraftState>()), title(std::move(t)) {}
-
-void Document::setState(std::unique_ptr<DocumentState> newState)
-{
-  state = std::move(newState);
+// transitions[state][role]
+constexpr std::array<std::array<Transition, roleCount>, stateCount> transitions{{
+    // Draft
+    {{{DocumentState::UnderReview, "Editor submits for review."},
+      {DocumentState::Draft, "Only Editor or Admin can publish."},
+      {DocumentState::Published, "Admin publishes directly."}}},
+    // Under Review
+    {{{DocumentState::UnderReview, "Only Moderator or Admin can publish."},
+      {DocumentState::Published, "Moderator approves and publishes."},
+      {DocumentState::Published, "Admin publishes."}}},
+    // Published
+    {{{DocumentState::Published, "Only Admin can archive."},
+      {DocumentState::Published, "Only Admin can archive."},
+      {DocumentState::Archived, "Admin archives the document."}}},
+    // Archived
+    {{{DocumentState::Archived, "No further actions allowed."},
+      {DocumentState::Archived, "No further actions allowed."},
+      {DocumentState::Archived, "No further actions allowed."}}},
+}};
+
+constexpr const Transition &transitionFor(DocumentState state, UserRole role)
+{
+  return transitions[std::size_t(state)][std::size_t(role)];
 }
 
-void Document::publish(UserRole user)
-{
-  state->publish(*this, user);
-}
+static_assert(transitionFor(DocumentState::Draft, UserRole::Editor).next == DocumentState::UnderReview);
+static_assert(transitionFor(DocumentState::Archived, UserRole::Admin).next == DocumentState::Archived,
+              "Archived is terminal");
 
-std::string Document::getStateName() const
-{
-  return state->name();
-}
-
-// State transitions and logic
-void DraftState::publish(Document &doc, UserRole user)
+// Document class
+class Document
 {
-  if (user == UserRole::Editor)
-  {
-    std::cout << "[Draft] " << doc.getTitle() << ": Editor submits for review.\n";
-    doc.setState(std::make_unique<UnderReviewState>());
-  }
-  else if (user == UserRole::Admin)
-  {
-    std::cout << "[Draft] " << doc.getTitle() << ": Admin publishes directly.\n";
-    doc.setState(std::make_unique<PublishedState>());
-  }
-  else
-  {
-    std::cout << "[Draft] " << doc.getTitle() << ": Only Editor or Admin can publish.\n";
-  }
-}
+  DocumentState state = DocumentState::Draft;
+  std::string title;
 
-void UnderReviewState::publish(Document &doc, UserRole user)
-{
-  if (user == UserRole::Moderator)
-  {
-    std::cout << "[Under Review] " << doc.getTitle() << ": Moderator approves and publishes.\n";
-    doc.setState(std::make_unique<PublishedState>());
-  }
-  else if (user == UserRole::Admin)
+public:
+  Document(std::string t) : title(std::move(t)) {}
+  void setState(DocumentState newState) { state = newState; }
+  DocumentState getState() const { return state; }
+  void publish(UserRole user, std::ostream &log = std::cout)
   {
-    std::cout << "[Under Review] " << doc.getTitle() << ": Admin publishes.\n";
-    doc.setState(std::make_unique<PublishedState>());
+    const Transition &t = transitionFor(state, user);
+    log << "[" << getStateName() << "] " << title << ": " << t.action << "\n";
+    state = t.next;
   }
-  else
+  // Applies the transition without logging; true if the state changed
+  bool advance(UserRole user)
   {
-    std::cout << "[Under Review] " << doc.getTitle() << ": Only Moderator or Admin can publish.\n";
+    DocumentState next = transitionFor(state, user).next;
+    bool changed = next != state;
+    state = next;
+    return changed;
   }
-}
+  std::string_view getStateName() const { return stateNames[std::size_t(state)]; }
+  const std::string &getTitle() const { return title; }
+};
 
-void PublishedState::publish(Document &doc, UserRole user)
+// Applies roles[i] to documents[i]; returns how many documents changed state
+std::size_t publishAll(std::span<Document> documents, std::span<const UserRole> roles)
 {
-  if (user == UserRole::Admin)
-  {
-    std::cout << "[Published] " << doc.getTitle() << ": Admin archives the document.\n";
-    doc.setState(std::make_unique<ArchivedState>());
-  }
-  else
+  if (documents.size() != roles.size())
+    throw std::invalid_argument("publishAll: one role per document is required");
+  std::size_t changed = 0;
+  for (std::size_t i = 0; i < documents.size(); ++i)
   {
-    std::cout << "[Published] " << doc.getTitle() << ": Only Admin can archive.\n";
+    changed += documents[i].advance(roles[i]);
   }
+  return changed;
 }
 
-void ArchivedState::publish(Document &doc, UserRole user)
-{
-  std::cout << "[Archived] " << doc.getTitle() << ": No further actions allowed.\n";
-}
-
+#ifndef DESIGN_PATTERNS_NO_MAIN
 // Demo
 int main()
 {
@@ -194,5 +158,16 @@ int main()
   doc.publish(UserRole::Editor); // Archived: No further actions
   std::cout << "Current State: " << doc.getStateName() << "\n";
 
+  // Bulk events: one role per document, no logging
+  Document batch[] = {Document("Release Notes"), Document("Style Guide"), Document("Roadmap")};
+  const UserRole roles[] = {UserRole::Editor, UserRole::Moderator, UserRole::Admin};
+  std::size_t changed = publishAll(batch, roles);
+  std::cout << "\npublishAll changed " << changed << " of 3 documents:\n";
+  for (const auto &d : batch)
+  {
+    std::cout << "  " << d.getTitle() << ": " << d.getStateName() << "\n";
+  }
+
   return 0;
 }
+#endif
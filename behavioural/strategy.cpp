@@ -15,81 +15,458 @@ How it works in this example:
 - The user can dynamically choose which strategies to use for each video.
 
 This pattern is especially useful when you want to avoid large conditional statements and allow easy extension of new algorithms or behaviors.
+
+Streaming Block Pipeline:
+- Strategies work on blocks of bytes: an overlay edits a block in place given its offset in the video, and a
+  compression appends the encoded block to an output buffer. Both are const and run on several threads at once.
+- The codecs are small stand-ins with real output: ZIP is PackBits run-length coding, H.264 codes the delta to
+  the previous byte and VP9 the XOR with the byte one row above, both followed by PackBits.
+- storeVideo(input, output) reads the file in fixed-size blocks with a buffered reader, overlays and compresses
+  each block on a worker pool and writes the blocks back in order from a writer thread.
+- Every stage draws from one fixed pool of block buffers, so memory stays at blocks * block size whatever the
+  file size; a full pool stops the reader until the writer hands a buffer back.
+- The reader uses read() rather than mmap so mapped file pages do not count towards the process's RSS.
+- storeVideoWholeFile() is the old two-step shape kept for comparison: it loads the whole file, overlays it,
+  then compresses it, producing the same bytes as the streaming path.
 */
 
 #include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <span>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+#include <system_error>
+#include <filesystem>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Bytes per video frame; overlays stamp each frame and VP9 predicts from the row above
+constexpr std::size_t videoFrameBytes = 64 * 1024;
+constexpr std::size_t videoRowBytes = 256;
+
+// PackBits: header n < 128 is followed by n + 1 literal bytes, header n >= 129 repeats the next byte 257 - n
+// times. `at(i)` yields the i-th filtered byte, so filters run inside the encoder without a scratch buffer.
+template <typename Source>
+void packBits(std::size_t size, Source at, std::vector<std::uint8_t> &out)
+{
+  std::size_t base = out.size();
+  out.resize(base + size + size / 128 + 1);
+  std::uint8_t *dst = out.data() + base;
+  std::size_t i = 0;
+  while (i < size)
+  {
+    std::uint8_t value = at(i);
+    std::size_t run = 1;
+    while (i + run < size && run < 128 && at(i + run) == value)
+      ++run;
+    if (run >= 3)
+    {
+      *dst++ = std::uint8_t(257 - run);
+      *dst++ = value;
+      i += run;
+      continue;
+    }
+    std::uint8_t *header = dst++;
+    std::size_t start = i;
+    while (i < size && i - start < 128)
+    {
+      std::uint8_t current = at(i);
+      if (i + 2 < size && at(i + 1) == current && at(i + 2) == current)
+        break;
+      *dst++ = current;
+      ++i;
+    }
+    *header = std::uint8_t(i - start - 1);
+  }
+  out.resize(std::size_t(dst - out.data()));
+}
 
 // Compression Strategy Interface
 class CompressionStrategy
 {
 public:
   virtual ~CompressionStrategy() = default;
-  virtual void compress(const std::string &filename) const = 0;
+  virtual std::string_view name() const = 0;
+  // Appends the encoding of block to out; blocks are coded independently of each other
+  virtual void compress(std::span<const std::uint8_t> block, std::vector<std::uint8_t> &out) const = 0;
 };
 
 // Concrete Compression Strategies
 class ZipCompression : public CompressionStrategy
 {
 public:
-  void compress(const std::string &filename) const override
+  std::string_view name() const override { return "ZIP compression"; }
+  void compress(std::span<const std::uint8_t> block, std::vector<std::uint8_t> &out) const override
   {
-    std::cout << "Compressing '" << filename << "' using ZIP compression.\n";
+    packBits(block.size(), [block](std::size_t i)
+             { return block[i]; },
+             out);
   }
 };
 
 class H264Compression : public CompressionStrategy
 {
 public:
-  void compress(const std::string &filename) const override
+  std::string_view name() const override { return "H.264 compression"; }
+  void compress(std::span<const std::uint8_t> block, std::vector<std::uint8_t> &out) const override
   {
-    std::cout << "Compressing '" << filename << "' using H.264 compression.\n";
+    packBits(block.size(), [block](std::size_t i)
+             { return std::uint8_t(i ? block[i] - block[i - 1] : block[0]); },
+             out);
   }
 };
 
 class VP9Compression : public CompressionStrategy
 {
 public:
-  void compress(const std::string &filename) const override
+  std::string_view name() const override { return "VP9 compression"; }
+  void compress(std::span<const std::uint8_t> block, std::vector<std::uint8_t> &out) const override
   {
-    std::cout << "Compressing '" << filename << "' using VP9 compression.\n";
+    packBits(block.size(), [block](std::size_t i)
+             { return std::uint8_t(i >= videoRowBytes ? block[i] ^ block[i - videoRowBytes] : block[i]); },
+             out);
   }
 };
 
+// Calls stamp(byte, frame, position) for the first `length` bytes of every frame that falls inside block
+template <typename Stamp>
+void forEachFrameHeader(std::span<std::uint8_t> block, std::uint64_t offset, std::size_t length, Stamp stamp)
+{
+  std::uint64_t end = offset + block.size();
+  for (std::uint64_t frame = offset / videoFrameBytes; frame * videoFrameBytes < end; ++frame)
+  {
+    std::uint64_t start = frame * videoFrameBytes;
+    for (std::size_t position = 0; position < length && start + position < end; ++position)
+    {
+      if (start + position >= offset)
+        stamp(block[start + position - offset], frame, position);
+    }
+  }
+}
+
 // Overlay Strategy Interface
 class OverlayStrategy
 {
 public:
   virtual ~OverlayStrategy() = default;
-  virtual void apply(const std::string &filename) const = 0;
+  virtual std::string_view name() const = 0;
+  // Edits block in place; offset is the position of block[0] in the video
+  virtual void apply(std::span<std::uint8_t> block, std::uint64_t offset) const = 0;
 };
 
 // Concrete Overlay Strategies
 class WatermarkOverlay : public OverlayStrategy
 {
+  static constexpr std::string_view logo = "(c) VideoStorage";
+
 public:
-  void apply(const std::string &filename) const override
+  std::string_view name() const override { return "watermark overlay"; }
+  void apply(std::span<std::uint8_t> block, std::uint64_t offset) const override
   {
-    std::cout << "Applying watermark overlay to '" << filename << "'.\n";
+    // Blends the logo into the start of each frame
+    forEachFrameHeader(block, offset, logo.size(), [](std::uint8_t &byte, std::uint64_t, std::size_t position)
+                       { byte = std::uint8_t((byte + std::uint8_t(logo[position])) / 2); });
   }
 };
 
 class TimestampOverlay : public OverlayStrategy
 {
 public:
-  void apply(const std::string &filename) const override
+  std::string_view name() const override { return "timestamp overlay"; }
+  void apply(std::span<std::uint8_t> block, std::uint64_t offset) const override
   {
-    std::cout << "Applying timestamp overlay to '" << filename << "'.\n";
+    // Writes the frame number as "#00000042" over the start of each frame
+    forEachFrameHeader(block, offset, 9, [](std::uint8_t &byte, std::uint64_t frame, std::size_t position)
+                       {
+                         if (position == 0)
+                         {
+                           byte = '#';
+                           return;
+                         }
+                         for (std::size_t digit = position; digit < 8; ++digit)
+                           frame /= 10;
+                         byte = std::uint8_t('0' + frame % 10);
+                       });
   }
 };
 
 class NoOverlay : public OverlayStrategy
 {
 public:
-  void apply(const std::string &filename) const override
+  std::string_view name() const override { return "no overlay"; }
+  void apply(std::span<std::uint8_t>, std::uint64_t) const override {}
+};
+
+struct StreamOptions
+{
+  std::size_t blockBytes = 1 << 20;
+  std::size_t workers = 0; // 0 = hardware threads
+  std::size_t blocks = 0;  // buffers in the pool; 0 = 2 * workers + 2
+};
+
+struct StoreStats
+{
+  std::uint64_t bytesIn = 0;
+  std::uint64_t bytesOut = 0;
+  std::uint64_t blocks = 0;
+};
+
+// Stored layout, per block: raw length and encoded length as native uint32, then the encoded bytes
+constexpr std::size_t blockHeaderBytes = 2 * sizeof(std::uint32_t);
+
+// Owns a file descriptor for the duration of one store
+class VideoFile
+{
+  int fd;
+
+public:
+  VideoFile(const std::string &path, int flags)
+      : fd(::open(path.c_str(), flags | O_CLOEXEC, 0644))
   {
-    std::cout << "No overlay applied to '" << filename << "'.\n";
+    if (fd < 0)
+      throw std::system_error(errno, std::generic_category(), "VideoFile: open '" + path + "'");
+  }
+  VideoFile(const VideoFile &) = delete;
+  VideoFile &operator=(const VideoFile &) = delete;
+  ~VideoFile() { ::close(fd); }
+
+  std::uint64_t size() const
+  {
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+      throw std::system_error(errno, std::generic_category(), "VideoFile: fstat");
+    return std::uint64_t(info.st_size);
+  }
+
+  // Fills buffer unless the file ends first; returns the bytes read
+  std::size_t read(std::span<std::uint8_t> buffer)
+  {
+    std::size_t done = 0;
+    while (done < buffer.size())
+    {
+      ssize_t got = ::read(fd, buffer.data() + done, buffer.size() - done);
+      if (got < 0 && errno == EINTR)
+        continue;
+      if (got < 0)
+        throw std::system_error(errno, std::generic_category(), "VideoFile: read");
+      if (got == 0)
+        break;
+      done += std::size_t(got);
+    }
+    return done;
+  }
+
+  void write(std::span<const std::uint8_t> bytes)
+  {
+    while (!bytes.empty())
+    {
+      ssize_t put = ::write(fd, bytes.data(), bytes.size());
+      if (put < 0 && errno == EINTR)
+        continue;
+      if (put < 0)
+        throw std::system_error(errno, std::generic_category(), "VideoFile: write");
+      bytes = bytes.subspan(std::size_t(put));
+    }
+  }
+};
+
+// Encodes one block with its header into out, reusing out's capacity
+void encodeBlock(const CompressionStrategy &compression, std::span<const std::uint8_t> raw,
+                 std::vector<std::uint8_t> &out)
+{
+  out.resize(blockHeaderBytes);
+  compression.compress(raw, out);
+  std::uint32_t header[2] = {std::uint32_t(raw.size()), std::uint32_t(out.size() - blockHeaderBytes)};
+  std::memcpy(out.data(), header, blockHeaderBytes);
+}
+
+// Read -> overlay + compress -> write over a fixed pool of block buffers; output keeps the input's block order.
+// Overlay and compression run back to back on the same worker so a block is still in that core's cache.
+class VideoPipeline
+{
+  struct Block
+  {
+    std::vector<std::uint8_t> raw;
+    std::vector<std::uint8_t> encoded;
+    std::size_t length = 0;
+    std::uint64_t index = 0;
+    std::uint64_t offset = 0;
+  };
+
+  const CompressionStrategy &compression;
+  const OverlayStrategy &overlay;
+  std::vector<Block> pool;
+  std::mutex lock;
+  std::condition_variable freed, queued, finished;
+  std::vector<Block *> freeBlocks;
+  std::deque<Block *> work;   // read, waiting for a worker
+  std::vector<Block *> ready; // encoded, slot index % pool size, waiting for the writer
+  std::uint64_t blocksRead = 0;
+  bool endOfInput = false;
+  std::exception_ptr error;
+  StoreStats stats;
+
+  void fail(std::exception_ptr failure)
+  {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      if (!error)
+        error = failure;
+    }
+    freed.notify_all();
+    queued.notify_all();
+    finished.notify_all();
+  }
+
+  template <typename Stage>
+  void guarded(Stage stage)
+  {
+    try
+    {
+      stage();
+    }
+    catch (...)
+    {
+      fail(std::current_exception());
+    }
+  }
+
+  void readBlocks(VideoFile &input)
+  {
+    for (std::uint64_t offset = 0;;)
+    {
+      Block *block;
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        freed.wait(guard, [this]()
+                   { return error || !freeBlocks.empty(); });
+        if (error)
+          return;
+        block = freeBlocks.back();
+        freeBlocks.pop_back();
+      }
+      block->length = input.read(block->raw);
+      if (block->length == 0)
+        break;
+      block->offset = offset;
+      offset += block->length;
+      stats.bytesIn += block->length;
+      bool last = block->length < block->raw.size();
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        block->index = blocksRead++;
+        work.push_back(block);
+      }
+      queued.notify_one();
+      if (last)
+        break;
+    }
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      endOfInput = true;
+    }
+    queued.notify_all();
+    finished.notify_all();
+  }
+
+  void encodeBlocks()
+  {
+    for (;;)
+    {
+      Block *block;
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        queued.wait(guard, [this]()
+                    { return error || endOfInput || !work.empty(); });
+        if (error || work.empty())
+          return;
+        block = work.front();
+        work.pop_front();
+      }
+      std::span<std::uint8_t> raw(block->raw.data(), block->length);
+      overlay.apply(raw, block->offset);
+      encodeBlock(compression, raw, block->encoded);
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        ready[block->index % ready.size()] = block;
+      }
+      finished.notify_one();
+    }
+  }
+
+  void writeBlocks(VideoFile &output)
+  {
+    for (std::uint64_t next = 0;; ++next)
+    {
+      Block *block;
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        Block *&slot = ready[next % ready.size()];
+        finished.wait(guard, [&]()
+                      { return error || slot || (endOfInput && next == blocksRead); });
+        if (error || !slot)
+          return;
+        block = slot;
+        slot = nullptr;
+      }
+      output.write(block->encoded);
+      stats.bytesOut += block->encoded.size();
+      ++stats.blocks;
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        freeBlocks.push_back(block);
+      }
+      freed.notify_one();
+    }
+  }
+
+public:
+  VideoPipeline(const CompressionStrategy &compression, const OverlayStrategy &overlay, std::size_t blocks,
+                std::size_t blockBytes)
+      : compression(compression), overlay(overlay), pool(blocks), ready(blocks, nullptr)
+  {
+    for (auto &block : pool)
+    {
+      block.raw.resize(blockBytes);
+      freeBlocks.push_back(&block);
+    }
+  }
+
+  // Runs the reader on the calling thread; rethrows the first failure of any stage
+  StoreStats run(VideoFile &input, VideoFile &output, std::size_t workers)
+  {
+    std::vector<std::thread> threads;
+    for (std::size_t w = 0; w < workers; ++w)
+    {
+      threads.emplace_back([this]()
+                           { guarded([this]()
+                                     { encodeBlocks(); }); });
+    }
+    threads.emplace_back([this, &output]()
+                         { guarded([this, &output]()
+                                   { writeBlocks(output); }); });
+    guarded([this, &input]()
+            { readBlocks(input); });
+    for (auto &thread : threads)
+    {
+      thread.join();
+    }
+    if (error)
+      std::rethrow_exception(error);
+    return stats;
   }
 };
 
@@ -99,6 +476,12 @@ class VideoStorage
   std::unique_ptr<CompressionStrategy> compressionStrategy;
   std::unique_ptr<OverlayStrategy> overlayStrategy;
 
+  void checkBlockSize(std::size_t blockBytes) const
+  {
+    if (blockBytes == 0 || blockBytes > UINT32_MAX / 2)
+      throw std::invalid_argument("VideoStorage: block size must be between 1 byte and 2 GB");
+  }
+
 public:
   VideoStorage(std::unique_ptr<CompressionStrategy> comp, std::unique_ptr<OverlayStrategy> overlay)
       : compressionStrategy(std::move(comp)), overlayStrategy(std::move(overlay)) {}
@@ -112,33 +495,103 @@ public:
     overlayStrategy = std::move(overlay);
   }
 
-  void storeVideo(const std::string &filename)
+  // Streams input through the overlay and compression strategies into output, one block at a time
+  StoreStats storeVideo(const std::string &input, const std::string &output, const StreamOptions &options = {})
   {
-    std::cout << "Storing video: '" << filename << "'\n";
-    compressionStrategy->compress(filename);
-    overlayStrategy->apply(filename);
-    std::cout << "Video '" << filename << "' stored successfully.\n\n";
+    checkBlockSize(options.blockBytes);
+    std::size_t workers = options.workers ? options.workers : std::max(1u, std::thread::hardware_concurrency());
+    std::size_t blocks = options.blocks ? options.blocks : 2 * workers + 2;
+    std::cout << "Storing video: '" << input << "' with " << overlayStrategy->name() << " and "
+              << compressionStrategy->name() << "\n";
+    VideoFile in(input, O_RDONLY);
+    VideoFile out(output, O_WRONLY | O_CREAT | O_TRUNC);
+    VideoPipeline pipeline(*compressionStrategy, *overlayStrategy, blocks, options.blockBytes);
+    StoreStats stats = pipeline.run(in, out, workers);
+    std::cout << "Video '" << input << "' stored successfully: " << stats.bytesIn << " -> " << stats.bytesOut
+              << " bytes in " << stats.blocks << " blocks.\n\n";
+    return stats;
+  }
+
+  // Whole-file baseline: loads input, overlays all of it, then compresses it; same output as storeVideo
+  StoreStats storeVideoWholeFile(const std::string &input, const std::string &output, std::size_t blockBytes = 1 << 20)
+  {
+    checkBlockSize(blockBytes);
+    VideoFile in(input, O_RDONLY);
+    std::vector<std::uint8_t> video(in.size());
+    video.resize(in.read(video));
+    overlayStrategy->apply(video, 0);
+
+    StoreStats stats;
+    stats.bytesIn = video.size();
+    std::vector<std::uint8_t> stored, encoded;
+    for (std::size_t offset = 0; offset < video.size(); offset += blockBytes)
+    {
+      std::span<const std::uint8_t> raw(video.data() + offset, std::min(blockBytes, video.size() - offset));
+      encodeBlock(*compressionStrategy, raw, encoded);
+      stored.insert(stored.end(), encoded.begin(), encoded.end());
+      ++stats.blocks;
+    }
+    stats.bytesOut = stored.size();
+    VideoFile out(output, O_WRONLY | O_CREAT | O_TRUNC);
+    out.write(stored);
+    return stats;
   }
 };
 
+// Synthetic footage drifting per frame: flat rows, then a horizontal gradient, with a noisy band in every eighth row
+void writeSampleVideo(const std::string &path, std::uint64_t bytes)
+{
+  VideoFile file(path, O_WRONLY | O_CREAT | O_TRUNC);
+  std::vector<std::uint8_t> frame(videoFrameBytes);
+  std::uint32_t noise = 12345;
+  for (std::uint64_t written = 0, index = 0; written < bytes; written += frame.size(), ++index)
+  {
+    for (std::size_t i = 0; i < frame.size(); ++i)
+    {
+      std::size_t row = i / videoRowBytes, column = i % videoRowBytes;
+      if (row % 8 == 7)
+      {
+        noise = noise * 1103515245 + 12345;
+        frame[i] = std::uint8_t(noise >> 24);
+      }
+      else if (i < frame.size() / 2)
+        frame[i] = std::uint8_t(row + index);
+      else
+        frame[i] = std::uint8_t(column + row + index);
+    }
+    file.write(std::span<const std::uint8_t>(frame).first(std::size_t(std::min<std::uint64_t>(frame.size(), bytes - written))));
+  }
+}
+
 // Demo
+#ifndef DESIGN_PATTERNS_NO_MAIN
 int main()
 {
+  std::filesystem::path directory = std::filesystem::temp_directory_path() / "strategy_demo_videos";
+  std::filesystem::create_directories(directory);
+  auto path = [&](const char *name)
+  { return (directory / name).string(); };
+  writeSampleVideo(path("holiday.mp4"), 3 << 20);
+  writeSampleVideo(path("lecture.webm"), 2 << 20);
+  writeSampleVideo(path("archive.avi"), 1 << 20);
+
   // User chooses H264 compression and watermark overlay
   VideoStorage storage(
       std::make_unique<H264Compression>(),
       std::make_unique<WatermarkOverlay>());
-  storage.storeVideo("holiday.mp4");
+  storage.storeVideo(path("holiday.mp4"), path("holiday.mp4.stored"));
 
   // User switches to VP9 compression and timestamp overlay
   storage.setCompressionStrategy(std::make_unique<VP9Compression>());
   storage.setOverlayStrategy(std::make_unique<TimestampOverlay>());
-  storage.storeVideo("lecture.webm");
+  storage.storeVideo(path("lecture.webm"), path("lecture.webm.stored"));
 
   // User switches to ZIP compression and no overlay
   storage.setCompressionStrategy(std::make_unique<ZipCompression>());
   storage.setOverlayStrategy(std::make_unique<NoOverlay>());
-  storage.storeVideo("archive.avi");
+  storage.storeVideo(path("archive.avi"), path("archive.avi.stored"));
 
+  std::filesystem::remove_all(directory);
   return 0;
 }
+#endif
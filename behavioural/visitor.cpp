@@ -24,11 +24,39 @@ We will model a simple shape hierarchy:
 - Each visitor can "visit" each shape and perform a calculation (area or perimeter).
 - The shape classes do not need to know the details of the operations.
 
+Batch Visitation:
+- ShapeCollection stores shapes by type in separate contiguous arrays (radii for circles, widths and heights for
+  rectangles) instead of one heap object per shape.
+- A ShapeBatchVisitor is dispatched once per type array rather than once per shape, and its loops run over plain
+  doubles, which the compiler can vectorize. AreaPerimeterBatchVisitor computes both totals in one fused pass.
+- For closed hierarchies, ShapeValue = std::variant<Circle, Rectangle> keeps shapes by value in one vector, in
+  their original order, and measure() dispatches with std::visit instead of virtual calls.
+- TotalsVisitor is the classic accept()/visit() form of the same reduction.
+
+Parallel Visitation:
+- parallelVisit<Visitor>(collection, pool) splits each type array into fixed-size chunks and runs them on a
+  ThreadPool. Every chunk is visited by its own Visitor, so threads never share an accumulator.
+- The per-chunk visitors are then merged in chunk order with Visitor::merge(). Chunk boundaries do not depend on
+  the thread count, so the totals are bit-identical between runs and for any pool size; a one-thread pool is
+  the sequential policy.
+
 */
 
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <span>
+#include <variant>
+#include <cstddef>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+#include <algorithm>
 using namespace std;
 
 // Forward declarations
@@ -108,6 +136,382 @@ public:
   }
 };
 
+// Result of a reduction over shapes
+struct ShapeTotals
+{
+  double area = 0;
+  double perimeter = 0;
+  size_t shapes = 0;
+};
+
+// Concrete Visitor: accumulates totals through accept()/visit()
+class TotalsVisitor : public ShapeVisitor
+{
+public:
+  ShapeTotals totals;
+  void visit(Circle &c) override
+  {
+    totals.area += M_PI * c.radius * c.radius;
+    totals.perimeter += 2 * M_PI * c.radius;
+    ++totals.shapes;
+  }
+  void visit(Rectangle &r) override
+  {
+    totals.area += r.width * r.height;
+    totals.perimeter += 2 * (r.width + r.height);
+    ++totals.shapes;
+  }
+};
+
+// Visitor over whole arrays of one shape type
+class ShapeBatchVisitor
+{
+public:
+  virtual void visitCircles(span<const double> radii) = 0;
+  virtual void visitRectangles(span<const double> widths, span<const double> heights) = 0;
+  virtual ~ShapeBatchVisitor() {}
+};
+
+// Object structure: shapes grouped by type, one array per field
+class ShapeCollection
+{
+  vector<double> radii;
+  vector<double> widths;
+  vector<double> heights;
+
+public:
+  void add(const Circle &c) { radii.push_back(c.radius); }
+  void add(const Rectangle &r)
+  {
+    widths.push_back(r.width);
+    heights.push_back(r.height);
+  }
+  void reserve(size_t circles, size_t rectangles)
+  {
+    radii.reserve(circles);
+    widths.reserve(rectangles);
+    heights.reserve(rectangles);
+  }
+  size_t circleCount() const { return radii.size(); }
+  size_t rectangleCount() const { return widths.size(); }
+  size_t size() const { return radii.size() + widths.size(); }
+  span<const double> circleRadii() const { return radii; }
+  span<const double> rectangleWidths() const { return widths; }
+  span<const double> rectangleHeights() const { return heights; }
+
+  void accept(ShapeBatchVisitor &visitor) const
+  {
+    visitor.visitCircles(radii);
+    visitor.visitRectangles(widths, heights);
+  }
+};
+
+// Sums over batches use four independent partial sums so the loops can be vectorized without -ffast-math;
+// the summation order is fixed, so results do not change between runs
+constexpr size_t batchLanes = 4;
+
+struct LaneSums
+{
+  double lane[batchLanes] = {};
+  double total() const { return (lane[0] + lane[1]) + (lane[2] + lane[3]); }
+};
+
+// Concrete Batch Visitor: total area
+class AreaBatchVisitor : public ShapeBatchVisitor
+{
+public:
+  double area = 0;
+  void merge(const AreaBatchVisitor &other) { area += other.area; }
+  void visitCircles(span<const double> radii) override
+  {
+    LaneSums squares;
+    size_t i = 0;
+    for (; i + batchLanes <= radii.size(); i += batchLanes)
+    {
+      for (size_t l = 0; l < batchLanes; ++l)
+        squares.lane[l] += radii[i + l] * radii[i + l];
+    }
+    for (; i < radii.size(); ++i)
+      squares.lane[0] += radii[i] * radii[i];
+    area += M_PI * squares.total();
+  }
+  void visitRectangles(span<const double> widths, span<const double> heights) override
+  {
+    LaneSums products;
+    size_t i = 0;
+    for (; i + batchLanes <= widths.size(); i += batchLanes)
+    {
+      for (size_t l = 0; l < batchLanes; ++l)
+        products.lane[l] += widths[i + l] * heights[i + l];
+    }
+    for (; i < widths.size(); ++i)
+      products.lane[0] += widths[i] * heights[i];
+    area += products.total();
+  }
+};
+
+// Concrete Batch Visitor: total perimeter
+class PerimeterBatchVisitor : public ShapeBatchVisitor
+{
+public:
+  double perimeter = 0;
+  void merge(const PerimeterBatchVisitor &other) { perimeter += other.perimeter; }
+  void visitCircles(span<const double> radii) override
+  {
+    LaneSums sums;
+    size_t i = 0;
+    for (; i + batchLanes <= radii.size(); i += batchLanes)
+    {
+      for (size_t l = 0; l < batchLanes; ++l)
+        sums.lane[l] += radii[i + l];
+    }
+    for (; i < radii.size(); ++i)
+      sums.lane[0] += radii[i];
+    perimeter += 2 * M_PI * sums.total();
+  }
+  void visitRectangles(span<const double> widths, span<const double> heights) override
+  {
+    LaneSums sums;
+    size_t i = 0;
+    for (; i + batchLanes <= widths.size(); i += batchLanes)
+    {
+      for (size_t l = 0; l < batchLanes; ++l)
+        sums.lane[l] += widths[i + l] + heights[i + l];
+    }
+    for (; i < widths.size(); ++i)
+      sums.lane[0] += widths[i] + heights[i];
+    perimeter += 2 * sums.total();
+  }
+};
+
+// Concrete Batch Visitor: area and perimeter in one pass over each array
+class AreaPerimeterBatchVisitor : public ShapeBatchVisitor
+{
+public:
+  ShapeTotals totals;
+  void merge(const AreaPerimeterBatchVisitor &other)
+  {
+    totals.area += other.totals.area;
+    totals.perimeter += other.totals.perimeter;
+    totals.shapes += other.totals.shapes;
+  }
+  void visitCircles(span<const double> radii) override
+  {
+    LaneSums squares, sums;
+    size_t i = 0;
+    for (; i + batchLanes <= radii.size(); i += batchLanes)
+    {
+      for (size_t l = 0; l < batchLanes; ++l)
+      {
+        double r = radii[i + l];
+        squares.lane[l] += r * r;
+        sums.lane[l] += r;
+      }
+    }
+    for (; i < radii.size(); ++i)
+    {
+      squares.lane[0] += radii[i] * radii[i];
+      sums.lane[0] += radii[i];
+    }
+    totals.area += M_PI * squares.total();
+    totals.perimeter += 2 * M_PI * sums.total();
+    totals.shapes += radii.size();
+  }
+  void visitRectangles(span<const double> widths, span<const double> heights) override
+  {
+    LaneSums products, sums;
+    size_t i = 0;
+    for (; i + batchLanes <= widths.size(); i += batchLanes)
+    {
+      for (size_t l = 0; l < batchLanes; ++l)
+      {
+        double w = widths[i + l], h = heights[i + l];
+        products.lane[l] += w * h;
+        sums.lane[l] += w + h;
+      }
+    }
+    for (; i < widths.size(); ++i)
+    {
+      products.lane[0] += widths[i] * heights[i];
+      sums.lane[0] += widths[i] + heights[i];
+    }
+    totals.area += products.total();
+    totals.perimeter += 2 * sums.total();
+    totals.shapes += widths.size();
+  }
+};
+
+// Fixed pool of threads; the thread calling parallelFor works alongside them
+class ThreadPool
+{
+  vector<thread> workers;
+  mutex lock;
+  condition_variable wake;
+  condition_variable done;
+  const function<void(size_t)> *task = nullptr;
+  size_t taskCount = 0;
+  atomic<size_t> nextTask{0};
+  size_t busy = 0; // workers that have not finished the current job
+  uint64_t generation = 0;
+  bool stopping = false;
+  exception_ptr failure;
+
+  void drain()
+  {
+    for (size_t i; (i = nextTask.fetch_add(1, memory_order_relaxed)) < taskCount;)
+    {
+      try
+      {
+        (*task)(i);
+      }
+      catch (...)
+      {
+        lock_guard<mutex> guard(lock);
+        if (!failure)
+          failure = current_exception();
+      }
+    }
+  }
+
+  void workerLoop()
+  {
+    uint64_t seen = 0;
+    unique_lock<mutex> guard(lock);
+    for (;;)
+    {
+      wake.wait(guard, [&]()
+                { return stopping || generation != seen; });
+      if (stopping)
+        return;
+      seen = generation;
+      guard.unlock();
+      drain();
+      guard.lock();
+      if (--busy == 0)
+        done.notify_one();
+    }
+  }
+
+public:
+  explicit ThreadPool(size_t threads = thread::hardware_concurrency())
+  {
+    threads = max<size_t>(threads, 1);
+    for (size_t i = 1; i < threads; ++i)
+    {
+      workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+  }
+  ~ThreadPool()
+  {
+    {
+      lock_guard<mutex> guard(lock);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto &w : workers)
+    {
+      w.join();
+    }
+  }
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  size_t threadCount() const { return workers.size() + 1; }
+
+  // Runs task(0) .. task(count - 1) and returns when all have finished, rethrowing the first exception;
+  // one caller at a time
+  void parallelFor(size_t count, const function<void(size_t)> &job)
+  {
+    {
+      lock_guard<mutex> guard(lock);
+      task = &job;
+      taskCount = count;
+      nextTask.store(0, memory_order_relaxed);
+      busy = workers.size();
+      failure = nullptr;
+      ++generation;
+    }
+    wake.notify_all();
+    drain();
+    unique_lock<mutex> guard(lock);
+    done.wait(guard, [&]()
+              { return busy == 0; });
+    task = nullptr;
+    if (failure)
+      rethrow_exception(exchange(failure, nullptr));
+  }
+};
+
+// Shapes per chunk in parallelVisit; fixed so results do not depend on the thread count
+constexpr size_t parallelChunk = size_t(1) << 16;
+
+// Visits collection in chunks on pool and merges the per-chunk visitors in order
+template <typename Visitor>
+Visitor parallelVisit(const ShapeCollection &collection, ThreadPool &pool)
+{
+  span<const double> radii = collection.circleRadii();
+  span<const double> widths = collection.rectangleWidths();
+  span<const double> heights = collection.rectangleHeights();
+  size_t circleChunks = (radii.size() + parallelChunk - 1) / parallelChunk;
+  size_t rectangleChunks = (widths.size() + parallelChunk - 1) / parallelChunk;
+
+  vector<Visitor> partial(circleChunks + rectangleChunks);
+  pool.parallelFor(partial.size(), [&](size_t chunk)
+                   {
+                     if (chunk < circleChunks)
+                     {
+                       size_t begin = chunk * parallelChunk;
+                       partial[chunk].visitCircles(radii.subspan(begin, min(parallelChunk, radii.size() - begin)));
+                     }
+                     else
+                     {
+                       size_t begin = (chunk - circleChunks) * parallelChunk;
+                       size_t length = min(parallelChunk, widths.size() - begin);
+                       partial[chunk].visitRectangles(widths.subspan(begin, length), heights.subspan(begin, length));
+                     }
+                   });
+
+  Visitor result;
+  for (const auto &p : partial)
+  {
+    result.merge(p);
+  }
+  return result;
+}
+
+// Closed alternative: shapes by value, dispatched with std::visit
+using ShapeValue = variant<Circle, Rectangle>;
+
+template <typename... Fs>
+struct Overloaded : Fs...
+{
+  using Fs::operator()...;
+};
+template <typename... Fs>
+Overloaded(Fs...) -> Overloaded<Fs...>;
+
+ShapeTotals measure(span<const ShapeValue> shapes)
+{
+  ShapeTotals totals;
+  for (const auto &shape : shapes)
+  {
+    visit(Overloaded{[&](const Circle &c)
+                     {
+                       totals.area += M_PI * c.radius * c.radius;
+                       totals.perimeter += 2 * M_PI * c.radius;
+                     },
+                     [&](const Rectangle &r)
+                     {
+                       totals.area += r.width * r.height;
+                       totals.perimeter += 2 * (r.width + r.height);
+                     }},
+          shape);
+  }
+  totals.shapes = shapes.size();
+  return totals;
+}
+
+#ifndef DESIGN_PATTERNS_NO_MAIN
 int main()
 {
   vector<Shape *> shapes;
@@ -129,8 +533,35 @@ int main()
     shape->accept(perimeterVisitor);
   }
 
+  cout << "\n-- Totals: accept()/visit(), ShapeCollection, std::variant --" << endl;
+  TotalsVisitor totalsVisitor;
+  for (auto *shape : shapes)
+  {
+    shape->accept(totalsVisitor);
+  }
+  cout << "TotalsVisitor: area = " << totalsVisitor.totals.area << ", perimeter = " << totalsVisitor.totals.perimeter
+       << endl;
+
+  ShapeCollection collection;
+  collection.add(Circle(3));
+  collection.add(Rectangle(4, 5));
+  AreaPerimeterBatchVisitor fused;
+  collection.accept(fused);
+  cout << "AreaPerimeterBatchVisitor: area = " << fused.totals.area << ", perimeter = " << fused.totals.perimeter
+       << " (" << collection.circleCount() << " circle, " << collection.rectangleCount() << " rectangle)" << endl;
+
+  ThreadPool pool(2);
+  auto parallel = parallelVisit<AreaPerimeterBatchVisitor>(collection, pool);
+  cout << "parallelVisit (" << pool.threadCount() << " threads): area = " << parallel.totals.area
+       << ", perimeter = " << parallel.totals.perimeter << endl;
+
+  vector<ShapeValue> values{Circle(3), Rectangle(4, 5)};
+  ShapeTotals totals = measure(values);
+  cout << "measure(variant): area = " << totals.area << ", perimeter = " << totals.perimeter << endl;
+
   // Clean up
   for (auto *shape : shapes)
     delete shape;
   return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,205 @@
+/*
+Benchmark Harness - shared by the bench/ suite
+----------------------------------------------
+Each bench/<pattern>.cpp defines DESIGN_PATTERNS_NO_MAIN, includes its pattern's source file and
+registers cases on a bench::Suite. The suite prints one JSON document on stdout, one result per
+line, so results from two commits can be diffed directly.
+
+The patterns print to std::cout on their hot paths; measured bodies run with std::cout redirected
+into a discarding buffer, so numbers include formatting but not terminal I/O.
+
+Command line (all optional):
+  --filter=<text>   run only cases whose name contains <text>
+  --min-time=<s>    minimum measured time for repeated cases (default 0.2)
+  --scale=<f>       multiply workload sizes of one-shot cases, e.g. 0.01 for a quick smoke run
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench
+{
+  // Keeps the optimizer from discarding a value the benchmark computes
+  template <typename T>
+  inline void doNotOptimize(const T &value)
+  {
+    asm volatile("" : : "g"(&value) : "memory");
+  }
+
+  // Stream buffer that discards everything
+  class NullBuffer : public std::streambuf
+  {
+  protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+  };
+
+  inline std::ostream &nullStream()
+  {
+    static NullBuffer buffer;
+    static std::ostream stream(&buffer);
+    return stream;
+  }
+
+  // Redirects std::cout into a NullBuffer for its lifetime
+  class QuietCout
+  {
+    std::streambuf *saved;
+
+  public:
+    QuietCout() : saved(std::cout.rdbuf(nullStream().rdbuf())) {}
+    ~QuietCout() { std::cout.rdbuf(saved); }
+    QuietCout(const QuietCout &) = delete;
+    QuietCout &operator=(const QuietCout &) = delete;
+  };
+
+  // q-th quantile (0..1) of samples, e.g. 0.99 for p99; reorders samples
+  inline double percentile(std::vector<double> &samples, double q)
+  {
+    if (samples.empty())
+      return 0;
+    size_t k = std::min(samples.size() - 1, size_t(q * double(samples.size())));
+    std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+    return samples[k];
+  }
+
+  inline double secondsSince(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  struct Result
+  {
+    std::string name;
+    uint64_t operations = 0;
+    double seconds = 0;
+    std::vector<std::pair<std::string, double>> counters;
+
+    // Extra named figures (bytes per item, speedups, ...) reported next to the timing
+    Result &counter(const std::string &key, double value)
+    {
+      counters.emplace_back(key, value);
+      return *this;
+    }
+  };
+
+  class Suite
+  {
+    std::string suiteName;
+    std::string filter;
+    double minTime = 0.2;
+    double scaleFactor = 1.0;
+    std::deque<Result> results; // Stable references for the Result& handed out
+    Result skipped;
+
+    static std::string jsonString(const std::string &s)
+    {
+      std::string out = "\"";
+      for (char c : s)
+      {
+        if (c == '"' || c == '\\')
+          out += '\\';
+        out += c;
+      }
+      return out + "\"";
+    }
+
+  public:
+    Suite(std::string name, int argc, char *argv[]) : suiteName(std::move(name))
+    {
+      for (int i = 1; i < argc; ++i)
+      {
+        std::string arg = argv[i];
+        if (arg.rfind("--filter=", 0) == 0)
+          filter = arg.substr(9);
+        else if (arg.rfind("--min-time=", 0) == 0)
+          minTime = std::atof(arg.c_str() + 11);
+        else if (arg.rfind("--scale=", 0) == 0)
+          scaleFactor = std::atof(arg.c_str() + 8);
+        else
+          std::cerr << suiteName << ": ignoring unknown argument '" << arg << "'\n";
+      }
+    }
+    ~Suite() { report(); }
+
+    // Workload size for one-shot cases after --scale, never below one
+    size_t scale(size_t n) const
+    {
+      return std::max<size_t>(1, size_t(double(n) * scaleFactor));
+    }
+    bool enabled(const std::string &name) const
+    {
+      return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    // Repeated case: body(n) performs n operations; n grows until one run takes at least min-time
+    template <typename F>
+    Result &run(const std::string &name, F &&body)
+    {
+      if (!enabled(name))
+        return skipped = Result();
+      uint64_t n = 1;
+      double elapsed = 0;
+      for (;;)
+      {
+        auto start = std::chrono::steady_clock::now();
+        {
+          QuietCout quiet;
+          body(n);
+        }
+        elapsed = secondsSince(start);
+        if (elapsed >= minTime || n >= (uint64_t(1) << 40))
+          break;
+        double grow = elapsed > 0 ? minTime * 1.2 / elapsed : 100.0;
+        n = uint64_t(double(n) * std::clamp(grow, 2.0, 100.0));
+      }
+      results.push_back({name, n, elapsed, {}});
+      return results.back();
+    }
+
+    // One-shot case: times a single call of body, which performs the given number of operations
+    template <typename F>
+    Result &runOnce(const std::string &name, uint64_t operations, F &&body)
+    {
+      if (!enabled(name))
+        return skipped = Result();
+      auto start = std::chrono::steady_clock::now();
+      {
+        QuietCout quiet;
+        body();
+      }
+      results.push_back({name, operations, secondsSince(start), {}});
+      return results.back();
+    }
+
+    void report(std::ostream &out = std::cout) const
+    {
+      std::ostringstream json;
+      json.precision(6);
+      json << "{\n  \"suite\": " << jsonString(suiteName) << ",\n  \"results\": [";
+      for (size_t i = 0; i < results.size(); ++i)
+      {
+        const Result &r = results[i];
+        double perOp = r.operations ? r.seconds / double(r.operations) : 0;
+        json << (i ? ",\n" : "\n") << "    {\"name\": " << jsonString(r.name) << ", \"operations\": " << r.operations
+             << ", \"ns_per_op\": " << perOp * 1e9 << ", \"ops_per_sec\": " << (r.seconds > 0 ? r.operations / r.seconds : 0);
+        for (const auto &[key, value] : r.counters)
+          json << ", " << jsonString(key) << ": " << value;
+        json << "}";
+      }
+      json << "\n  ]\n}\n";
+      out << json.str();
+    }
+  };
+}
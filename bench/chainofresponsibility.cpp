@@ -0,0 +1,169 @@
+// Chain of Responsibility benchmarks: handle() through authentication, authorization and content,
+// and requests/sec for the linked setNext chain against the frozen and compile-time chains, and the
+// decision cache in front of a simulated identity-service lookup
+
+#include "bench.h"
+
+#define DESIGN_PATTERNS_NO_MAIN
+#include "../behavioural/chainofresponsibility.cpp"
+
+#include <random>
+#include <thread>
+
+// 70% served, 20% not authorized, 10% not authenticated
+vector<HttpRequest> makeTraffic(size_t count)
+{
+  const string users[] = {"alice", "bob", "carol", "dave", "erin", "frank"};
+  const string pages[] = {"home.html", "admin.html", "blog.html", "account.html"};
+  mt19937 rng(5);
+  vector<HttpRequest> requests(count);
+  for (auto &r : requests)
+  {
+    unsigned roll = rng() % 10;
+    r = {users[rng() % 6], roll != 0, roll >= 3, pages[rng() % 4]};
+  }
+  return requests;
+}
+
+// Authorization backed by a remote lookup, modelled as ~2us of busy work
+class RemoteAuthorizationHandler : public Handler
+{
+public:
+  static bool process(HttpRequest &request, ostream *log)
+  {
+    auto until = chrono::steady_clock::now() + chrono::microseconds(2);
+    while (chrono::steady_clock::now() < until)
+    {
+    }
+    return AuthorizationHandler::process(request, log);
+  }
+  Stage stage() const override { return &process; }
+};
+
+void benchmarkDecisionCache(bench::Suite &suite)
+{
+  // 20k distinct (username, page) pairs, drawn with a skew towards a hot set
+  const size_t users = 5000, pages = 4;
+  const size_t count = suite.scale(2000000);
+  mt19937 rng(9);
+  vector<HttpRequest> traffic(count);
+  for (auto &r : traffic)
+  {
+    size_t u = rng() % 8 ? rng() % 200 : rng() % users;
+    r = {"user" + to_string(u), true, u % 5 != 0, "page" + to_string((u + rng()) % pages) + ".html"};
+  }
+
+  RemoteAuthorizationHandler remote;
+  size_t maxThreads = max(4u, thread::hardware_concurrency());
+  for (size_t threads = 1; threads <= maxThreads; threads *= 2)
+  {
+    auto drive = [&](size_t requests, auto &&check)
+    {
+      vector<thread> workers;
+      for (size_t t = 0; t < threads; ++t)
+      {
+        workers.emplace_back([&, t]()
+                             {
+                               size_t served = 0;
+                               for (size_t i = t; i < requests; i += threads)
+                               {
+                                 HttpRequest request = traffic[i];
+                                 served += check(request);
+                               }
+                               bench::doNotOptimize(served);
+                             });
+      }
+      for (auto &w : workers)
+      {
+        w.join();
+      }
+    };
+
+    // The uncached case runs a tenth of the traffic; ops_per_sec stays comparable
+    const size_t uncached = max<size_t>(1, count / 10);
+    suite.runOnce("authorize/uncached/threads:" + to_string(threads), uncached, [&]()
+                  { drive(uncached, [](HttpRequest &r)
+                          { return RemoteAuthorizationHandler::process(r, nullptr); }); })
+        .counter("threads", threads);
+
+    DecisionCacheHandler cache(remote);
+    bench::Result &cached = suite.runOnce("authorize/cached/threads:" + to_string(threads), count, [&]()
+                                          { drive(count, [&](HttpRequest &r)
+                                                  { return cache.check(r); }); });
+    DecisionCacheStats stats = cache.stats();
+    uint64_t lookups = stats.hits + stats.misses + stats.coalesced;
+    cached.counter("threads", threads)
+        .counter("hit_rate", lookups ? double(stats.hits) / lookups : 0)
+        .counter("coalesced", stats.coalesced)
+        .counter("entries", stats.size);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  bench::Suite suite("chainofresponsibility", argc, argv);
+
+  AuthenticationHandler authn;
+  AuthorizationHandler authz;
+  ContentHandler content;
+  authn.setNext(&authz);
+  authz.setNext(&content);
+
+  HttpRequest accepted{"alice", true, true, "home.html"};
+  HttpRequest rejected{"bob", false, false, "admin.html"};
+  suite.run("Handler/handle/accepted", [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                authn.handle(accepted);
+            });
+  suite.run("Handler/handle/rejected", [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                authn.handle(rejected);
+            });
+
+  const size_t count = suite.scale(1000000);
+  vector<HttpRequest> traffic = makeTraffic(count);
+  CompiledChain compiled = freeze(authn);
+  using AccessChain = StaticChain<AuthenticationHandler, AuthorizationHandler, ContentHandler>;
+  ostream &sink = bench::nullStream();
+  size_t served = 0;
+
+  // Logged: every path formats the same messages into a discarding stream
+  suite.runOnce("traffic/linked/logged", count, [&]()
+                {
+                  for (auto &r : traffic)
+                    authn.handle(r);
+                });
+  suite.runOnce("traffic/compiled/logged", count, [&]()
+                {
+                  for (auto &r : traffic)
+                    served += compiled.handle(r, &sink);
+                });
+  suite.runOnce("traffic/handleBatch/logged", count, [&]()
+                { served += compiled.handleBatch(traffic, &sink); });
+
+  // Quiet: decisions only
+  suite.runOnce("traffic/compiled", count, [&]()
+                {
+                  for (auto &r : traffic)
+                    served += compiled.handle(r);
+                });
+  suite.runOnce("traffic/static", count, [&]()
+                {
+                  for (auto &r : traffic)
+                    served += AccessChain::handle(r);
+                });
+  const size_t batch = 4096;
+  suite.runOnce("traffic/handleBatch:4096", count, [&]()
+                {
+                  span<HttpRequest> all(traffic);
+                  for (size_t i = 0; i < all.size(); i += batch)
+                    served += compiled.handleBatch(all.subspan(i, min(batch, all.size() - i)));
+                })
+      .counter("accepted", double(compiled.accepted().size()));
+  bench::doNotOptimize(served);
+
+  benchmarkDecisionCache(suite);
+  return 0;
+}
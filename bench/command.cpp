@@ -0,0 +1,275 @@
+// Command benchmarks: execute() through the RemoteControl invoker, and queued execution from many
+// producers against a mutex-guarded vector<unique_ptr<Command>>, and the undo/redo journal
+
+#include "bench.h"
+
+#define DESIGN_PATTERNS_NO_MAIN
+#include "../behavioural/command.cpp"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+// Records how long the command waited between submit and execute
+struct LatencyRecord
+{
+  std::vector<double> *latencies;
+  std::size_t index;
+  Clock::time_point submitted;
+  void operator()() const
+  {
+    (*latencies)[index] = std::chrono::duration<double, std::micro>(Clock::now() - submitted).count();
+  }
+};
+
+class LatencyCommand : public Command
+{
+  LatencyRecord record;
+
+public:
+  LatencyCommand(const LatencyRecord &r) : record(r) {}
+  void execute() override
+  {
+    record();
+  }
+};
+
+// Baseline queue: producers push heap-allocated commands under one mutex, the worker swaps them out
+class LockedCommandQueue
+{
+  std::mutex lock;
+  std::vector<std::unique_ptr<Command>> pending;
+  std::atomic<bool> stopping{false};
+  std::thread worker;
+
+public:
+  LockedCommandQueue()
+      : worker([this]()
+               {
+                 std::vector<std::unique_ptr<Command>> batch;
+                 for (;;)
+                 {
+                   {
+                     std::lock_guard<std::mutex> guard(lock);
+                     batch.swap(pending);
+                   }
+                   if (batch.empty())
+                   {
+                     if (stopping)
+                       return;
+                     std::this_thread::yield();
+                     continue;
+                   }
+                   for (auto &command : batch)
+                     command->execute();
+                   batch.clear();
+                 } })
+  {
+  }
+  ~LockedCommandQueue()
+  {
+    stopping = true;
+    worker.join();
+  }
+  void submit(std::unique_ptr<Command> command)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    pending.push_back(std::move(command));
+  }
+};
+
+template <typename Submit>
+void runProducers(std::size_t producers, std::size_t commands, std::vector<double> &latencies, Submit submit)
+{
+  std::vector<std::thread> threads;
+  for (std::size_t p = 0; p < producers; ++p)
+  {
+    threads.emplace_back([&, p]()
+                         {
+                           for (std::size_t i = p; i < commands; i += producers)
+                             submit(LatencyRecord{&latencies, i, Clock::now()});
+                         });
+  }
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+}
+
+void recordLatency(bench::Result &result, std::vector<double> &latencies, std::size_t producers)
+{
+  result.counter("producers", double(producers))
+      .counter("latency_p50_us", bench::percentile(latencies, 0.5))
+      .counter("latency_p99_us", bench::percentile(latencies, 0.99))
+      .counter("latency_p999_us", bench::percentile(latencies, 0.999));
+}
+
+void benchmarkQueues(bench::Suite &suite)
+{
+  const std::size_t commands = suite.scale(2000000);
+  std::vector<double> latencies(commands);
+  std::size_t maxThreads = std::max(4u, std::thread::hardware_concurrency());
+  for (std::size_t producers = 1; producers <= maxThreads; producers *= 2)
+  {
+    std::string shape = "/producers:" + std::to_string(producers);
+    bench::Result &locked = suite.runOnce("queue/mutex+vector<unique_ptr>" + shape, commands, [&]()
+                                          {
+                                            LockedCommandQueue queue;
+                                            runProducers(producers, commands, latencies, [&](const LatencyRecord &r)
+                                                         { queue.submit(std::make_unique<LatencyCommand>(r)); });
+                                          });
+    recordLatency(locked, latencies, producers);
+
+    RemoteControl remote;
+    remote.start(1 << 16);
+    bench::Result &inlined = suite.runOnce("queue/RemoteControl::submit" + shape, commands, [&]()
+                                           {
+                                             runProducers(producers, commands, latencies, [&](const LatencyRecord &r)
+                                                          { remote.submit(r); });
+                                             remote.flush();
+                                           });
+    recordLatency(inlined, latencies, producers);
+    remote.stop();
+  }
+}
+
+// Silent receiver so the journal numbers are not dominated by printing
+struct AdjustCommand
+{
+  std::int64_t *value;
+  std::int64_t delta;
+  void execute() { *value += delta; }
+  void undo() { *value -= delta; }
+};
+
+struct MergingAdjustCommand : AdjustCommand
+{
+  bool mergeWith(const MergingAdjustCommand &next)
+  {
+    delta += next.delta;
+    return true;
+  }
+};
+
+class VirtualAdjustCommand : public UndoableCommand
+{
+  AdjustCommand command;
+
+public:
+  VirtualAdjustCommand(const AdjustCommand &c) : command(c) {}
+  void execute() override { command.execute(); }
+  void undo() override { command.undo(); }
+};
+
+void benchmarkJournal(bench::Suite &suite)
+{
+  const std::size_t entries = suite.scale(10000000);
+  std::int64_t value = 0;
+
+  {
+    std::vector<std::unique_ptr<UndoableCommand>> history;
+    suite.runOnce("journal/vector<unique_ptr>/execute", entries, [&]()
+                  {
+                    for (std::size_t i = 0; i < entries; ++i)
+                    {
+                      auto command = std::make_unique<VirtualAdjustCommand>(AdjustCommand{&value, std::int64_t(i % 7)});
+                      command->execute();
+                      history.push_back(std::move(command));
+                    }
+                  })
+        // pointer slot plus the allocation, rounded to malloc's 16-byte chunks with its 8-byte header
+        .counter("bytes_per_entry", double(sizeof(void *) + (sizeof(VirtualAdjustCommand) + 8 + 15) / 16 * 16));
+    suite.runOnce("journal/vector<unique_ptr>/undo", entries, [&]()
+                  {
+                    for (auto it = history.rbegin(); it != history.rend(); ++it)
+                      (*it)->undo();
+                  });
+  }
+
+  CommandJournal journal;
+  suite.runOnce("journal/CommandJournal/execute", entries, [&]()
+                {
+                  for (std::size_t i = 0; i < entries; ++i)
+                    journal.execute(AdjustCommand{&value, std::int64_t(i % 7)});
+                })
+      .counter("bytes_per_entry", double(journal.memoryUsed()) / double(journal.size()));
+  suite.runOnce("journal/CommandJournal/undo", entries, [&]()
+                {
+                  while (journal.undo())
+                  {
+                  }
+                });
+  suite.runOnce("journal/CommandJournal/redo", entries, [&]()
+                {
+                  while (journal.redo())
+                  {
+                  }
+                });
+  bench::doNotOptimize(value);
+
+  CommandJournal merging;
+  suite.runOnce("journal/CommandJournal/execute/merging", entries, [&]()
+                {
+                  for (std::size_t i = 0; i < entries; ++i)
+                    merging.execute(MergingAdjustCommand{{&value, 1}});
+                })
+      .counter("entries", double(merging.size()))
+      .counter("merged", double(merging.merged()));
+
+  const std::size_t cap = 16 << 20;
+  CommandJournal capped(cap);
+  suite.runOnce("journal/CommandJournal/execute/cap:16MB", entries, [&]()
+                {
+                  for (std::size_t i = 0; i < entries; ++i)
+                    capped.execute(AdjustCommand{&value, 1});
+                })
+      .counter("memory_bytes", double(capped.memoryUsed()))
+      .counter("entries", double(capped.size()))
+      .counter("evicted", double(capped.evicted()));
+}
+
+int main(int argc, char *argv[])
+{
+  bench::Suite suite("command", argc, argv);
+
+  Light light;
+  RemoteControl remote;
+  remote.setCommand(0, std::make_unique<LightOnCommand>(light), std::make_unique<LightOffCommand>(light));
+  suite.run("RemoteControl/pressOnButton", [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                remote.pressOnButton(0);
+            });
+
+  std::vector<std::unique_ptr<Command>> commands;
+  std::vector<InlineCommand> inlineCommands;
+  for (int i = 0; i < 64; ++i)
+  {
+    if (i % 2)
+      commands.push_back(std::make_unique<LightOnCommand>(light));
+    else
+      commands.push_back(std::make_unique<LightOffCommand>(light));
+    if (i % 2)
+      inlineCommands.emplace_back([&light]()
+                                  { light.on(); });
+    else
+      inlineCommands.emplace_back([&light]()
+                                  { light.off(); });
+  }
+  suite.run("Command/execute/vector<unique_ptr>", [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                commands[i % commands.size()]->execute();
+            });
+  suite.run("Command/execute/vector<InlineCommand>", [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                inlineCommands[i % inlineCommands.size()]();
+            });
+
+  benchmarkQueues(suite);
+  benchmarkJournal(suite);
+  return 0;
+}
@@ -0,0 +1,125 @@
+// Composite benchmarks: Box vs flattened PackageTree getPrice(), updates and printContents()
+
+#include "bench.h"
+
+#define DESIGN_PATTERNS_NO_MAIN
+#include "../structural/composite.cpp"
+
+// Package of `boxes` boxes per level, `depth` levels deep, each box holding `items` items
+shared_ptr<Box> buildPackage(size_t depth, size_t boxes, size_t items, size_t &nodes)
+{
+  auto box = make_shared<Box>("Box");
+  ++nodes;
+  for (size_t i = 0; i < items; ++i, ++nodes)
+    box->add(make_shared<Item>("Item", 1.0 + double(i % 10)));
+  if (depth > 0)
+  {
+    for (size_t b = 0; b < boxes; ++b)
+      box->add(buildPackage(depth - 1, boxes, items, nodes));
+  }
+  return box;
+}
+
+// Runs getPrice() on the Box tree and its flattened copy, plus a price update and an add()
+void benchmarkShape(bench::Suite &suite, const string &shape, const shared_ptr<Box> &package, size_t nodes)
+{
+  suite.run("Box/getPrice/" + shape, [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                bench::doNotOptimize(package->getPrice());
+            })
+      .counter("nodes", nodes);
+
+  PackageTree tree;
+  suite.runOnce("PackageTree/build/" + shape, nodes, [&]()
+                { tree = PackageTree(*package); });
+  suite.run("PackageTree/getPrice/" + shape, [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                bench::doNotOptimize(tree.getPrice());
+            })
+      .counter("nodes", nodes);
+
+  // Mutate the deepest item, then read the total, as a manifest edit followed by a re-quote
+  size_t deepest = tree.size() - 1;
+  suite.run("PackageTree/setPrice+getPrice/" + shape, [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+              {
+                tree.setPrice(deepest, double(i % 10));
+                bench::doNotOptimize(tree.getPrice());
+              }
+            })
+      .counter("nodes", nodes);
+
+  const size_t adds = 100;
+  Item extra("Extra", 1.0);
+  size_t lastBox = 0;
+  for (size_t i = 0; i < tree.size(); ++i)
+  {
+    if (tree.isBox(i))
+      lastBox = i;
+  }
+  suite.runOnce("PackageTree/add/" + shape, adds, [&]()
+                {
+                  for (size_t i = 0; i < adds; ++i)
+                    tree.add(lastBox, extra);
+                })
+      .counter("nodes", nodes);
+}
+
+// Multi-million-node manifest: 64 pallets of 64 cartons, each pallet and carton holding `items` items
+void benchmarkParallel(bench::Suite &suite)
+{
+  const size_t items = max<size_t>(suite.scale(500), 1);
+  size_t nodes = 0;
+  auto manifest = make_shared<Box>("Manifest");
+  ++nodes;
+  for (size_t p = 0; p < 64; ++p)
+  {
+    manifest->add(buildPackage(1, 64, items, nodes));
+  }
+  suite.runOnce("Box/getPrice/manifest", nodes, [&]()
+                { bench::doNotOptimize(manifest->getPrice()); });
+  suite.runOnce("Box/printContents/manifest", nodes, [&]()
+                { manifest->printContents(); });
+
+  size_t maxThreads = max(4u, thread::hardware_concurrency());
+  for (size_t threads = 1; threads <= maxThreads; threads *= 2)
+  {
+    WorkStealingExecutor executor(threads);
+    suite.runOnce("Box/getPriceParallel/manifest/threads:" + to_string(threads), nodes, [&]()
+                  { bench::doNotOptimize(manifest->getPriceParallel(executor)); })
+        .counter("threads", threads);
+    suite.runOnce("Box/printContentsParallel/manifest/threads:" + to_string(threads), nodes, [&]()
+                  { manifest->printContentsParallel(executor); })
+        .counter("threads", threads);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  bench::Suite suite("composite", argc, argv);
+
+  size_t nodes = 0;
+  auto package = buildPackage(4, 4, 8, nodes);
+  benchmarkShape(suite, "balanced", package, nodes);
+
+  size_t deepNodes = 0;
+  auto deep = buildPackage(suite.scale(2000), 1, 2, deepNodes);
+  benchmarkShape(suite, "deep", deep, deepNodes);
+
+  size_t wideNodes = 0;
+  auto wide = buildPackage(0, 0, suite.scale(200000), wideNodes);
+  benchmarkShape(suite, "wide", wide, wideNodes);
+
+  suite.run("Box/printContents/nodes:" + to_string(nodes), [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                package->printContents();
+            })
+      .counter("nodes", nodes);
+
+  benchmarkParallel(suite);
+  return 0;
+}
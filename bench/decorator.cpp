@@ -0,0 +1,81 @@
+// Decorator benchmarks: cost() and getDescription() through a chain of condiment wrappers, against a
+// flattened CoffeeRecipe and a compile-time Decorated<> chain, at depths 1, 10 and 100
+
+#include "bench.h"
+
+#define DESIGN_PATTERNS_NO_MAIN
+#include "../structural/decorator.cpp"
+
+#include <type_traits>
+#include <utility>
+
+// Alternating Milk, Sugar, Milk, ...
+shared_ptr<Coffee> makeChain(size_t depth)
+{
+  shared_ptr<Coffee> coffee = make_shared<SimpleCoffee>();
+  for (size_t i = 0; i < depth; ++i)
+  {
+    if (i % 2 == 0)
+      coffee = make_shared<Milk>(coffee);
+    else
+      coffee = make_shared<Sugar>(coffee);
+  }
+  return coffee;
+}
+
+template <size_t... I>
+Decorated<SimpleCoffee, conditional_t<I % 2 == 0, Milk, Sugar>...> decoratedOf(index_sequence<I...>);
+
+template <size_t Depth>
+using AlternatingDecorated = decltype(decoratedOf(make_index_sequence<Depth>()));
+
+template <size_t Depth>
+void benchmarkDepth(bench::Suite &suite)
+{
+  const string depth = "depth:" + to_string(Depth);
+  shared_ptr<Coffee> chain = makeChain(Depth);
+  CoffeeRecipe recipe = flatten(*chain);
+  AlternatingDecorated<Depth> fixed;
+  const Coffee &fixedCoffee = fixed;
+
+  suite.run("Coffee/cost/" + depth, [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                bench::doNotOptimize(chain->cost());
+            });
+  suite.run("CoffeeRecipe/cost/" + depth, [&](uint64_t n)
+            {
+              const Coffee &flat = recipe;
+              for (uint64_t i = 0; i < n; ++i)
+                bench::doNotOptimize(flat.cost());
+            });
+  suite.run("Decorated/cost/" + depth, [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                bench::doNotOptimize(fixedCoffee.cost());
+            });
+  suite.run("Coffee/getDescription/" + depth, [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                bench::doNotOptimize(chain->getDescription());
+            });
+  suite.run("CoffeeRecipe/description/" + depth, [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                bench::doNotOptimize(recipe.description().size());
+            });
+  suite.run("flatten/" + depth, [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                bench::doNotOptimize(flatten(*chain));
+            });
+}
+
+int main(int argc, char *argv[])
+{
+  bench::Suite suite("decorator", argc, argv);
+  benchmarkDepth<1>(suite);
+  benchmarkDepth<10>(suite);
+  benchmarkDepth<100>(suite);
+  return 0;
+}
@@ -0,0 +1,95 @@
+// Facade benchmarks: orders/sec for the per-order placeOrder loop against batched placeOrders and the
+// pipelined submit(), with every subsystem request costing a simulated 200 us round trip
+
+#include "bench.h"
+
+#define DESIGN_PATTERNS_NO_MAIN
+#include "../structural/facade.cpp"
+
+#include <random>
+
+const chrono::microseconds roundTrip(200);
+
+// 100 items with plenty of stock but two scarce ones, 1% declined customers, 200 addresses
+void configure(OrderFacade &facade)
+{
+  for (int i = 0; i < 100; ++i)
+  {
+    facade.getInventory().setStock("item" + to_string(i), i < 2 ? 10 : 1000000);
+  }
+  for (int c = 0; c < 1000; c += 100)
+  {
+    facade.getPayment().declineCustomer("customer" + to_string(c));
+  }
+}
+
+vector<Order> makeOrders(size_t count)
+{
+  mt19937 rng(8);
+  vector<Order> orders(count);
+  for (auto &o : orders)
+  {
+    o = {"customer" + to_string(rng() % 1000), "item" + to_string(rng() % 100), 10.0 + rng() % 500,
+         to_string(rng() % 200) + " Main St"};
+  }
+  return orders;
+}
+
+size_t placedCount(const vector<OrderStatus> &results)
+{
+  return size_t(count(results.begin(), results.end(), OrderStatus::Placed));
+}
+
+int main(int argc, char *argv[])
+{
+  bench::Suite suite("facade", argc, argv);
+  bench::QuietCout quiet;
+  const size_t batch = 64;
+
+  {
+    vector<Order> orders = makeOrders(suite.scale(2000));
+    OrderFacade facade(roundTrip);
+    configure(facade);
+    size_t placed = 0;
+    suite.runOnce("placeOrder/loop", orders.size(), [&]()
+                  {
+                    for (const auto &o : orders)
+                      placed += facade.placeOrder(o) == OrderStatus::Placed;
+                  })
+        .counter("round_trips", facade.roundTrips())
+        .counter("placed", placed);
+  }
+
+  vector<Order> orders = makeOrders(suite.scale(20000));
+  {
+    OrderFacade facade(roundTrip);
+    configure(facade);
+    size_t placed = 0;
+    suite.runOnce("placeOrders/batch:64", orders.size(), [&]()
+                  {
+                    span<const Order> all(orders);
+                    for (size_t i = 0; i < all.size(); i += batch)
+                      placed += placedCount(facade.placeOrders(all.subspan(i, min(batch, all.size() - i))));
+                  })
+        .counter("round_trips", facade.roundTrips())
+        .counter("placed", placed);
+  }
+  {
+    OrderFacade facade(roundTrip);
+    configure(facade);
+    facade.startPipeline();
+    size_t placed = 0;
+    suite.runOnce("pipeline/batch:64", orders.size(), [&]()
+                  {
+                    vector<future<vector<OrderStatus>>> pending;
+                    for (size_t i = 0; i < orders.size(); i += batch)
+                      pending.push_back(facade.submit(vector<Order>(orders.begin() + i, orders.begin() + min(i + batch, orders.size()))));
+                    for (auto &f : pending)
+                      placed += placedCount(f.get());
+                  })
+        .counter("round_trips", facade.roundTrips())
+        .counter("placed", placed);
+    facade.stopPipeline();
+  }
+  return 0;
+}
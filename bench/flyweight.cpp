@@ -0,0 +1,182 @@
+// Flyweight benchmarks: factory lookups, plantTree, memory per tree, draw paths and viewport culling
+
+#include "bench.h"
+
+#define DESIGN_PATTERNS_NO_MAIN
+#include "../structural/flyweight.cpp"
+
+#include <chrono>
+#include <random>
+
+// Stands in for an instanced renderer: consumes each batch without formatting
+class CountingSink : public Sink
+{
+public:
+  size_t instances = 0;
+  int64_t checksum = 0;
+  void drawInstances(const TreeType &, span<const Position> positions) override
+  {
+    instances += positions.size();
+    for (const auto &p : positions)
+    {
+      checksum += p.x + p.y;
+    }
+  }
+};
+
+// Baseline for the concurrent factory: the single-threaded TreeFactory behind one global mutex
+class LockedTreeFactory
+{
+  mutex lock;
+  TreeFactory factory;
+
+public:
+  const TreeType *getTreeType(string_view name, string_view color, string_view texture)
+  {
+    lock_guard<mutex> guard(lock);
+    return factory.getTreeType(name, color, texture);
+  }
+};
+
+// Threads share one factory; mostly hits with a warm-up miss per type, as in level loading
+template <typename Factory>
+void loadChunks(Factory &factory, size_t threads, size_t lookups, const vector<string> &names)
+{
+  vector<thread> loaders;
+  for (size_t t = 0; t < threads; ++t)
+  {
+    loaders.emplace_back([&factory, &names, lookups, threads, t]()
+                         {
+                           for (size_t i = t; i < lookups; i += threads)
+                           {
+                             bench::doNotOptimize(factory.getTreeType(names[i % names.size()], "Green", "Rough"));
+                           }
+                         });
+  }
+  for (auto &loader : loaders)
+  {
+    loader.join();
+  }
+}
+
+void benchmarkFactories(bench::Suite &suite)
+{
+  const string names[] = {"Oak", "Pine", "Birch", "Maple"};
+  TreeFactory factory;
+  suite.run("TreeFactory/getTreeType/hit", [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                bench::doNotOptimize(factory.getTreeType(names[i % 4], "Green", "Rough"));
+            });
+
+  const size_t misses = suite.scale(1000000);
+  vector<string> fresh(misses);
+  for (size_t i = 0; i < misses; ++i)
+  {
+    fresh[i] = "Tree" + to_string(i);
+  }
+  TreeFactory coldFactory;
+  suite.runOnce("TreeFactory/getTreeType/miss", misses, [&]()
+                {
+                  for (const auto &name : fresh)
+                    bench::doNotOptimize(coldFactory.getTreeType(name, "Green", "Rough"));
+                });
+
+  vector<string> chunkNames(1000);
+  for (size_t i = 0; i < chunkNames.size(); ++i)
+  {
+    chunkNames[i] = "Tree" + to_string(i);
+  }
+  const size_t lookups = suite.scale(4000000);
+  size_t maxThreads = max(4u, thread::hardware_concurrency());
+  for (size_t threads = 1; threads <= maxThreads; threads *= 2)
+  {
+    ConcurrentTreeFactory concurrent;
+    suite.runOnce("ConcurrentTreeFactory/threads:" + to_string(threads), lookups, [&]()
+                  { loadChunks(concurrent, threads, lookups, chunkNames); })
+        .counter("threads", threads);
+    LockedTreeFactory locked;
+    suite.runOnce("MutexTreeFactory/threads:" + to_string(threads), lookups, [&]()
+                  { loadChunks(locked, threads, lookups, chunkNames); })
+        .counter("threads", threads);
+  }
+}
+
+void benchmarkLayouts(bench::Suite &suite)
+{
+  const string names[] = {"Oak", "Pine", "Birch", "Maple"};
+  const size_t count = suite.scale(1000000);
+  ostream &sink = bench::nullStream();
+
+  Forest forest;
+  suite.runOnce("Forest/plantTree", count, [&]()
+                {
+                  for (size_t i = 0; i < count; ++i)
+                    forest.plantTree(int(i), int(i * 7), names[i % 4], "Green", "Rough");
+                })
+      .counter("bytes_per_tree", sizeof(Tree));
+  suite.runOnce("Forest/draw", count, [&]()
+                { forest.draw(sink); });
+
+  CompactForest compact;
+  suite.runOnce("CompactForest/plantTree", count, [&]()
+                {
+                  for (size_t i = 0; i < count; ++i)
+                    compact.plantTree(int(i), int(i * 7), names[i % 4], "Green", "Rough");
+                })
+      .counter("bytes_per_tree", CompactForest::bytesPerTree);
+
+  CompactForest bulk;
+  uint16_t ids[4];
+  for (int t = 0; t < 4; ++t)
+  {
+    ids[t] = bulk.getTreeTypeId(names[t], "Green", "Rough");
+  }
+  vector<TreePlacement> placements(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    placements[i] = {int(i), int(i * 7), ids[i % 4]};
+  }
+  suite.runOnce("CompactForest/plantTrees", count, [&]()
+                { bulk.plantTrees(placements); });
+  suite.runOnce("CompactForest/draw", count, [&]()
+                { compact.draw(sink); });
+
+  CountingSink counter;
+  ConsoleSink console(sink);
+  suite.runOnce("Forest/drawBatched", count, [&]()
+                { forest.drawBatched(counter); });
+  suite.runOnce("CompactForest/drawBatched", count, [&]()
+                { compact.drawBatched(counter); });
+  suite.runOnce("CompactForest/drawBatched/ConsoleSink", count, [&]()
+                { compact.drawBatched(console); });
+}
+
+// Forest scattered over a square world; the viewport covers 1% of its area
+void benchmarkViewport(bench::Suite &suite)
+{
+  const int world = 10000;
+  const size_t count = suite.scale(10000000);
+  mt19937 rng(42);
+  uniform_int_distribution<int> coord(0, world - 1);
+
+  Forest forest;
+  for (size_t i = 0; i < count; ++i)
+  {
+    forest.plantTree(coord(rng), coord(rng), i % 2 ? "Oak" : "Pine", "Green", "Rough");
+  }
+  Rect viewport{4500, 4500, world / 10, world / 10};
+  suite.runOnce("Forest/draw/viewport:1%", count, [&]()
+                { forest.draw(viewport, bench::nullStream()); });
+  suite.runOnce("Forest/drawLinear/viewport:1%", count, [&]()
+                { forest.drawLinear(viewport, bench::nullStream()); });
+}
+
+int main(int argc, char *argv[])
+{
+  bench::Suite suite("flyweight", argc, argv);
+  benchmarkLayouts(suite);
+  benchmarkFactories(suite);
+  benchmarkViewport(suite);
+  return 0;
+}
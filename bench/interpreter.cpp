@@ -0,0 +1,190 @@
+// Interpreter benchmarks: parsing, tree-walk vs bytecode, batch evaluation and optimize()
+
+#include "bench.h"
+
+#define DESIGN_PATTERNS_NO_MAIN
+#include "../behavioural/interpreter.cpp"
+
+#include <optional>
+#include <random>
+
+// Long left-deep chain "1 + 1 - 2 + 3 ..."
+string generateChain(size_t terms)
+{
+  string expr = "1";
+  for (size_t i = 1; i < terms; ++i)
+  {
+    expr += (i % 2 ? " + " : " - ") + to_string(i % 100);
+  }
+  return expr;
+}
+
+// Random full binary expression; each level reuses a few earlier subtrees, as generated rules do
+string generateExpression(size_t depth, mt19937 &rng, vector<vector<string>> &pool)
+{
+  static const char *leaves[] = {"a", "b", "c", "d", "1", "2", "3", "5"};
+  if (depth == 0)
+    return leaves[rng() % 8];
+  auto &seen = pool[depth];
+  if (seen.size() >= 4 && rng() % 2)
+    return seen[rng() % seen.size()];
+  string left = generateExpression(depth - 1, rng, pool);
+  string right = generateExpression(depth - 1, rng, pool);
+  string expr = "(" + left + (rng() % 2 ? " + " : " - ") + right + ")";
+  if (seen.size() < 16)
+    seen.push_back(expr);
+  return expr;
+}
+
+void benchmarkEvaluation(bench::Suite &suite)
+{
+  const size_t terms = 1000;
+  const uint64_t nodes = 2 * terms - 1;
+  string expr = generateChain(terms);
+
+  suite.run("parse/chain:1000/heap", [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                bench::doNotOptimize(parse(expr));
+            });
+  suite.run("parse/chain:1000/arena", [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+              {
+                ExpressionArena arena;
+                bench::doNotOptimize(parse(expr, &arena));
+              }
+            });
+
+  auto heapTree = parse(expr);
+  ExpressionArena arena;
+  auto arenaTree = parse(expr, &arena);
+  CompiledExpression program = compile(*heapTree);
+  suite.run("interpret/chain:1000/heap", [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                bench::doNotOptimize(heapTree->interpret());
+            })
+      .counter("nodes", nodes);
+  suite.run("interpret/chain:1000/arena", [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                bench::doNotOptimize(arenaTree->interpret());
+            })
+      .counter("nodes", nodes);
+  suite.run("bytecode/chain:1000", [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                bench::doNotOptimize(program.evaluate());
+            })
+      .counter("nodes", nodes)
+      .counter("instructions", program.size());
+}
+
+void benchmarkParseMany(bench::Suite &suite)
+{
+  const size_t lines = suite.scale(1000000);
+  string buffer;
+  for (size_t i = 0; i < lines; ++i)
+  {
+    buffer += to_string(i % 1000) + " + (" + to_string(i % 77) + " - 3) - " + to_string(i % 13) + " + 42\n";
+  }
+  double megabytes = buffer.size() / 1e6;
+
+  bench::Result &heap = suite.runOnce("parseMany/heap", lines, [&]()
+                                      { bench::doNotOptimize(parseMany(buffer)); });
+  heap.counter("mb_per_sec", heap.seconds > 0 ? megabytes / heap.seconds : 0);
+  ExpressionArena arena;
+  bench::Result &arenaRun = suite.runOnce("parseMany/arena", lines, [&]()
+                                          { bench::doNotOptimize(parseMany(buffer, &arena)); });
+  arenaRun.counter("mb_per_sec", arenaRun.seconds > 0 ? megabytes / arenaRun.seconds : 0);
+}
+
+void benchmarkBatch(bench::Suite &suite)
+{
+  const size_t rows = suite.scale(10000000);
+  Variables variables;
+  auto rule = parse("price - discount + 5 - (tax - bonus) + price - 7", nullptr, &variables);
+  CompiledExpression program = compile(*rule);
+  vector<vector<int>> data(variables.size(), vector<int>(rows));
+  for (size_t c = 0; c < data.size(); ++c)
+  {
+    for (size_t r = 0; r < rows; ++r)
+      data[c][r] = int((r * 31 + c * 7) % 1000);
+  }
+  vector<Row> columns(data.begin(), data.end());
+  vector<int> out(rows);
+  vector<int> row(variables.size());
+
+  suite.runOnce("rule/interpret/per-row", rows, [&]()
+                {
+                  for (size_t r = 0; r < rows; ++r)
+                  {
+                    for (size_t c = 0; c < row.size(); ++c)
+                      row[c] = data[c][r];
+                    bench::doNotOptimize(rule->interpret(row));
+                  }
+                });
+  suite.runOnce("rule/bytecode/per-row", rows, [&]()
+                {
+                  for (size_t r = 0; r < rows; ++r)
+                  {
+                    for (size_t c = 0; c < row.size(); ++c)
+                      row[c] = data[c][r];
+                    bench::doNotOptimize(program.evaluate(row));
+                  }
+                });
+  suite.runOnce("rule/evaluateBatch", rows, [&]()
+                { program.evaluateBatch(columns, out); });
+  bench::doNotOptimize(out);
+}
+
+void benchmarkOptimize(bench::Suite &suite)
+{
+  const size_t depth = 16;
+  mt19937 rng(7);
+  vector<vector<string>> pool(depth + 1);
+  Variables variables;
+  auto tree = parse(generateExpression(depth, rng, pool), nullptr, &variables);
+
+  optional<OptimizedExpression> optimized;
+  bench::Result &pass = suite.runOnce("optimize/depth:16", 1, [&]()
+                                      { optimized.emplace(optimize(*tree)); });
+  if (!optimized)
+    optimized.emplace(optimize(*tree));
+  pass.counter("nodes_before", optimized->report().nodesBefore)
+      .counter("nodes_after", optimized->report().nodesAfter)
+      .counter("constants_folded", optimized->report().constantsFolded)
+      .counter("shared_subtrees", optimized->report().sharedSubtrees);
+
+  // One variable changes between evaluations, as when a rule is re-scored after an edit
+  const size_t runs = 200;
+  vector<int> row(variables.size(), 1);
+  suite.runOnce("optimize/depth:16/tree-walk", runs, [&]()
+                {
+                  for (size_t i = 0; i < runs; ++i)
+                  {
+                    row[i % row.size()] = int(i);
+                    bench::doNotOptimize(tree->interpret(row));
+                  }
+                });
+  fill(row.begin(), row.end(), 1);
+  suite.runOnce("optimize/depth:16/incremental", runs, [&]()
+                {
+                  for (size_t i = 0; i < runs; ++i)
+                  {
+                    row[i % row.size()] = int(i);
+                    bench::doNotOptimize(optimized->evaluate(row));
+                  }
+                });
+}
+
+int main(int argc, char *argv[])
+{
+  bench::Suite suite("interpreter", argc, argv);
+  benchmarkEvaluation(suite);
+  benchmarkParseMany(suite);
+  benchmarkBatch(suite);
+  benchmarkOptimize(suite);
+  return 0;
+}
@@ -0,0 +1,99 @@
+// Iterator benchmarks: one pass over 10M shopping list items through the polymorphic next(), nextBatch()
+// chunks, getItem() indexing, range-for and the span view
+
+#include "bench.h"
+
+#define DESIGN_PATTERNS_NO_MAIN
+#include "../behavioural/iterator.cpp"
+
+#include <list>
+
+// Non-contiguous aggregate: its iterator relies on the default, copying nextBatch()
+class LinkedIterator : public Iterator
+{
+  std::list<std::string>::const_iterator current, last;
+
+public:
+  explicit LinkedIterator(const std::list<std::string> &items) : current(items.begin()), last(items.end()) {}
+  bool hasNext() const override { return current != last; }
+  const std::string &next() override { return *current++; }
+};
+
+int main(int argc, char *argv[])
+{
+  bench::Suite suite("iterator", argc, argv);
+  const size_t count = suite.scale(10000000);
+  ShoppingList list;
+  for (size_t i = 0; i < count; ++i)
+  {
+    list.addItem("item" + std::to_string(i % 100000));
+  }
+  const size_t batchSize = 1024;
+
+  suite.runOnce("Iterator/next", count, [&]()
+                {
+                  std::size_t bytes = 0;
+                  auto it = list.createIterator();
+                  while (it->hasNext())
+                    bytes += it->next().size();
+                  bench::doNotOptimize(bytes);
+                });
+  suite.runOnce("Iterator/nextBatch:1024", count, [&]()
+                {
+                  std::size_t bytes = 0;
+                  auto it = list.createIterator();
+                  for (auto batch = it->nextBatch(batchSize); !batch.empty(); batch = it->nextBatch(batchSize))
+                  {
+                    for (const auto &item : batch)
+                      bytes += item.size();
+                  }
+                  bench::doNotOptimize(bytes);
+                });
+  suite.runOnce("ShoppingList/getItem", count, [&]()
+                {
+                  std::size_t bytes = 0;
+                  for (std::size_t i = 0; i < list.size(); ++i)
+                    bytes += list.getItem(i).size();
+                  bench::doNotOptimize(bytes);
+                });
+  suite.runOnce("ShoppingList/range-for", count, [&]()
+                {
+                  std::size_t bytes = 0;
+                  for (const auto &item : list)
+                    bytes += item.size();
+                  bench::doNotOptimize(bytes);
+                });
+  suite.runOnce("ShoppingList/view", count, [&]()
+                {
+                  std::size_t bytes = 0;
+                  std::span<const std::string> items = list.view();
+                  for (std::size_t i = 0; i < items.size(); ++i)
+                    bytes += items[i].size();
+                  bench::doNotOptimize(bytes);
+                });
+
+  // Default nextBatch() over a linked aggregate copies each item once
+  const size_t linkedCount = suite.scale(1000000);
+  std::list<std::string> linked(list.begin(), list.begin() + linkedCount);
+  suite.runOnce("LinkedIterator/next", linkedCount, [&]()
+                {
+                  std::size_t bytes = 0;
+                  LinkedIterator it(linked);
+                  while (it.hasNext())
+                    bytes += it.next().size();
+                  bench::doNotOptimize(bytes);
+                });
+  suite.runOnce("LinkedIterator/nextBatch:1024", linkedCount, [&]()
+                {
+                  std::size_t bytes = 0;
+                  LinkedIterator it(linked);
+                  Iterator &base = it;
+                  for (auto batch = base.nextBatch(batchSize); !batch.empty(); batch = base.nextBatch(batchSize))
+                  {
+                    for (const auto &item : batch)
+                      bytes += item.size();
+                  }
+                  bench::doNotOptimize(bytes);
+                });
+  return 0;
+}
@@ -0,0 +1,86 @@
+// Mediator benchmarks: broadcast vs topic-indexed notify, sync and queued, as registered posts grow
+
+#include "bench.h"
+
+#define DESIGN_PATTERNS_NO_MAIN
+#include "../behavioural/mediator.cpp"
+
+#include <deque>
+
+// The original Blog: every event goes to every registered post
+class BroadcastBlog : public Blog
+{
+  vector<BlogPost *> everyone;
+
+public:
+  void registerPost(BlogPost *post) override
+  {
+    everyone.push_back(post);
+    post->setMediator(this);
+  }
+  void notify(BlogPost *sender, EventId event) override
+  {
+    const string &name = eventName(event);
+    for (auto *post : everyone)
+    {
+      post->notifyEvent(name, sender);
+    }
+  }
+};
+
+const size_t topics = 64;
+
+// Posts each follow one of `topics` events; notifications cycle through the topics
+template <typename BlogType>
+void benchmarkBlog(bench::Suite &suite, const string &name, size_t postCount, bool queued)
+{
+  BlogType blog;
+  vector<EventId> events;
+  for (size_t t = 0; t < topics; ++t)
+  {
+    events.push_back(blog.internEvent("topic-" + to_string(t)));
+  }
+  deque<BlogPost> posts;
+  size_t deliveries = 0;
+  for (size_t i = 0; i < postCount; ++i)
+  {
+    BlogPost &post = posts.emplace_back("Post " + to_string(i), "...");
+    if constexpr (is_same_v<BlogType, BroadcastBlog>)
+      blog.registerPost(&post);
+    else
+    {
+      blog.registerPost(&post, {});
+      blog.subscribe(&post, events[i % topics]);
+    }
+  }
+  BlogPost &sender = posts.front();
+  const size_t notifications = max<size_t>(suite.scale(5000000 / postCount), topics);
+  for (size_t n = 0; n < notifications; ++n)
+  {
+    deliveries += is_same_v<BlogType, BroadcastBlog> ? postCount : blog.subscriberCount(events[n % topics]);
+  }
+
+  if (queued)
+    blog.startDispatcher();
+  suite.runOnce(name + "/posts:" + to_string(postCount), notifications, [&]()
+                {
+                  for (size_t n = 0; n < notifications; ++n)
+                    blog.notify(&sender, events[n % topics]);
+                  blog.flush();
+                })
+      .counter("posts", postCount)
+      .counter("deliveries_per_notify", double(deliveries) / double(notifications));
+  blog.stopDispatcher();
+}
+
+int main(int argc, char *argv[])
+{
+  bench::Suite suite("mediator", argc, argv);
+  for (size_t postCount : {100, 1000, 10000, 50000})
+  {
+    benchmarkBlog<BroadcastBlog>(suite, "Blog/notify/broadcast", postCount, false);
+    benchmarkBlog<Blog>(suite, "Blog/notify/topic", postCount, false);
+    benchmarkBlog<Blog>(suite, "Blog/notify/topic/queued", postCount, true);
+  }
+  return 0;
+}
@@ -0,0 +1,140 @@
+// Memento benchmarks: full-copy Memento vs chunked copy-on-write DocumentMemento on a 10 MB state,
+// and the file-backed FileCaretaker with 1M entries
+
+#include "bench.h"
+
+#define DESIGN_PATTERNS_NO_MAIN
+#include "../behavioural/memento.cpp"
+
+#include <chrono>
+#include <random>
+
+// Bytes held by all mementos together, counting each shared chunk once
+size_t retainedBytes(const BasicCaretaker<DocumentMemento> &history)
+{
+  DocumentMemento none;
+  size_t bytes = 0;
+  for (size_t i = 0; i < history.size(); ++i)
+  {
+    bytes += history.getMemento(i).bytesNotIn(i ? history.getMemento(i - 1) : none);
+  }
+  return bytes;
+}
+
+// 1M-entry FileCaretaker: append, reopen, random restores and showHistory over the index
+void benchmarkFileCaretaker(bench::Suite &suite)
+{
+  const size_t entries = std::max<size_t>(suite.scale(1000000), 1);
+  std::filesystem::path dir = std::filesystem::temp_directory_path() / "design_patterns_bench_memento";
+  std::filesystem::remove_all(dir);
+  {
+    FileCaretaker log(dir);
+    std::string state(100, 'x');
+    suite.runOnce("FileCaretaker/addMemento/state:100B", entries, [&]()
+                  {
+                    for (size_t i = 0; i < entries; ++i)
+                    {
+                      char prefix[32];
+                      int length = std::snprintf(prefix, sizeof(prefix), "State #%08zu", i);
+                      state.replace(0, size_t(length), prefix, size_t(length));
+                      log.addMemento(Memento(state));
+                    }
+                    log.sync();
+                  });
+  }
+
+  std::unique_ptr<FileCaretaker> reopened;
+  suite.runOnce("FileCaretaker/open/entries:" + std::to_string(entries), 1, [&]()
+                { reopened = std::make_unique<FileCaretaker>(dir); })
+      .counter("entries", reopened ? double(reopened->size()) : 0.0);
+  if (!reopened)
+    reopened = std::make_unique<FileCaretaker>(dir);
+
+  // Filtering out the append case leaves an empty history
+  const size_t available = reopened->size();
+  const size_t restores = available ? std::min<size_t>(available, 100000) : 0;
+  std::mt19937 rng(3);
+  std::vector<double> latencies(restores);
+  Originator originator;
+  suite.runOnce("FileCaretaker/restore/random", restores, [&]()
+                {
+                  for (size_t i = 0; i < restores; ++i)
+                  {
+                    size_t index = rng() % available;
+                    auto start = std::chrono::steady_clock::now();
+                    originator.restoreFromMemento(reopened->getMemento(index));
+                    latencies[i] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+                  }
+                })
+      .counter("latency_p50_us", bench::percentile(latencies, 0.5))
+      .counter("latency_p99_us", bench::percentile(latencies, 0.99));
+  suite.runOnce("FileCaretaker/showHistory", entries, [&]()
+                { reopened->showHistory(bench::nullStream()); });
+  reopened.reset();
+  std::filesystem::remove_all(dir);
+}
+
+int main(int argc, char *argv[])
+{
+  bench::Suite suite("memento", argc, argv);
+
+  const size_t stateBytes = 10 << 20;
+  const size_t snapshots = std::max<size_t>(suite.scale(1000), 2);
+  const std::string initial(stateBytes, 'x');
+  std::mt19937 rng(11);
+  auto editAt = [&]()
+  { return size_t(rng() % (stateBytes - 32)); };
+
+  // Full copies cost 10 MB each, so the baseline keeps only a few
+  const size_t fullSnapshots = std::min<size_t>(snapshots, 20);
+  Originator plain;
+  plain.setState(initial);
+  Caretaker plainHistory;
+  std::string edited = initial;
+  suite.runOnce("Memento/save/state:10MB", fullSnapshots, [&]()
+                {
+                  for (size_t i = 0; i < fullSnapshots; ++i)
+                  {
+                    edited.replace(editAt(), 16, "small edit #0001");
+                    plain.setState(edited);
+                    plainHistory.addMemento(plain.saveToMemento());
+                  }
+                })
+      .counter("bytes_per_snapshot", double(stateBytes));
+  suite.runOnce("Memento/restore/state:10MB", fullSnapshots, [&]()
+                {
+                  for (size_t i = 0; i < fullSnapshots; ++i)
+                    plain.restoreFromMemento(plainHistory.getMemento(i));
+                });
+
+  DocumentOriginator document;
+  document.setState(initial);
+  BasicCaretaker<DocumentMemento> history;
+  suite.runOnce("DocumentMemento/edit+save/state:10MB", snapshots, [&]()
+                {
+                  for (size_t i = 0; i < snapshots; ++i)
+                  {
+                    document.replace(editAt(), 16, "small edit #0001");
+                    history.addMemento(document.saveToMemento());
+                  }
+                })
+      .counter("bytes_per_snapshot", double(retainedBytes(history)) / double(std::max<size_t>(history.size(), 1)))
+      .counter("retained_mb", double(retainedBytes(history)) / 1e6)
+      .counter("chunks_per_snapshot", history.size() ? double(history.getMemento(0).chunkCount()) : 0.0);
+  suite.runOnce("DocumentMemento/restore/state:10MB", snapshots, [&]()
+                {
+                  for (size_t i = 0; i < snapshots; ++i)
+                    document.restoreFromMemento(history.getMemento(i));
+                });
+  suite.runOnce("DocumentMemento/restore+edit/state:10MB", snapshots, [&]()
+                {
+                  for (size_t i = 0; i < snapshots; ++i)
+                  {
+                    document.restoreFromMemento(history.getMemento(i));
+                    document.replace(editAt(), 16, "small edit #0002");
+                  }
+                });
+
+  benchmarkFileCaretaker(suite);
+  return 0;
+}
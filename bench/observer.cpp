@@ -0,0 +1,222 @@
+// Observer benchmarks: sync notify() vs the async SnapshotBus, writer and delivery latency
+
+#include "bench.h"
+
+#define DESIGN_PATTERNS_NO_MAIN
+#include "../behavioural/observer.cpp"
+
+// Sync observer that only reads the data, so notify() cost is dispatch, not printing
+class CountingObserver : public Observer
+{
+  Spreadsheet1 &sheet;
+
+public:
+  CountingObserver(Spreadsheet1 &s) : sheet(s) {}
+  int64_t sum = 0;
+  chrono::microseconds delay{0};
+  void update() override
+  {
+    if (delay.count())
+      this_thread::sleep_for(delay);
+    sum += sheet.getData().front();
+  }
+};
+
+// Async observer recording publish-to-delivery latency; only its executor thread touches it
+class LatencyObserver : public AsyncObserver
+{
+public:
+  vector<double> latencies;
+  chrono::microseconds delay{0};
+  void onSnapshot(const DataSnapshot &snapshot) override
+  {
+    if (delay.count())
+      this_thread::sleep_for(delay);
+    latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - snapshot.getPublished()).count());
+  }
+};
+
+// Times each setData() call; returns per-write latencies in microseconds
+vector<double> timeWrites(Spreadsheet1 &sheet, size_t writes)
+{
+  vector<double> latencies(writes);
+  vector<int> data(64);
+  for (size_t w = 0; w < writes; ++w)
+  {
+    data[0] = int(w);
+    auto start = chrono::steady_clock::now();
+    sheet.setData(data);
+    latencies[w] = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+  }
+  return latencies;
+}
+
+void benchmarkDispatch(bench::Suite &suite, size_t observers, bool slowObserver)
+{
+  const size_t writes = suite.scale(slowObserver ? 2000 : 20000);
+  string shape = "observers:" + to_string(observers) + (slowObserver ? "/one-slow" : "");
+
+  {
+    Spreadsheet1 sheet;
+    deque<CountingObserver> sync;
+    for (size_t i = 0; i < observers; ++i)
+    {
+      sheet.attach(&sync.emplace_back(sheet));
+    }
+    if (slowObserver)
+      sync.front().delay = chrono::microseconds(100);
+    vector<double> latencies;
+    bench::Result &r = suite.runOnce("sync/setData/" + shape, writes, [&]()
+                                     { latencies = timeWrites(sheet, writes); });
+    r.counter("writer_p50_us", bench::percentile(latencies, 0.5)).counter("writer_p99_us", bench::percentile(latencies, 0.99));
+  }
+
+  Spreadsheet1 sheet(observers);
+  deque<SerialExecutor> executors(min<size_t>(observers, 4));
+  deque<LatencyObserver> async(observers);
+  for (size_t i = 0; i < observers; ++i)
+  {
+    sheet.attachAsync(&async[i], executors[i % executors.size()]);
+  }
+  if (slowObserver)
+    async.front().delay = chrono::microseconds(100);
+  vector<double> writerLatencies;
+  bench::Result &r = suite.runOnce("async/setData/" + shape, writes, [&]()
+                                   {
+                                     writerLatencies = timeWrites(sheet, writes);
+                                     for (auto &executor : executors)
+                                       executor.waitIdle();
+                                   });
+  vector<double> delivery;
+  for (auto &observer : async)
+  {
+    delivery.insert(delivery.end(), observer.latencies.begin(), observer.latencies.end());
+  }
+  r.counter("writer_p50_us", bench::percentile(writerLatencies, 0.5))
+      .counter("writer_p99_us", bench::percentile(writerLatencies, 0.99))
+      .counter("delivery_p50_us", bench::percentile(delivery, 0.5))
+      .counter("delivery_p99_us", bench::percentile(delivery, 0.99))
+      .counter("deliveries_per_observer", double(delivery.size()) / double(observers));
+  for (auto &observer : async)
+  {
+    sheet.detachAsync(&observer);
+  }
+}
+
+// Keeps a running total of the sheet; the full observer re-reads every cell on each update
+class SummingObserver : public Observer
+{
+protected:
+  Spreadsheet1 &sheet;
+
+public:
+  int64_t total = 0;
+  SummingObserver(Spreadsheet1 &s) : sheet(s) {}
+  void update() override
+  {
+    total = 0;
+    for (int value : sheet.getData())
+      total += value;
+  }
+};
+
+// Same total, maintained from change-sets against a private copy of the cells
+class DeltaSummingObserver : public SummingObserver
+{
+  vector<int> mirror;
+
+public:
+  using SummingObserver::SummingObserver;
+  using SummingObserver::update;
+  void update() override
+  {
+    SummingObserver::update();
+    mirror = sheet.getData();
+  }
+  void update(const ChangeSet &changes) override
+  {
+    for (size_t i = 0; i < changes.rangeCount(); ++i)
+    {
+      span<const int> values = changes.rangeValues(i);
+      int *cells = mirror.data() + changes.rangeBegin(i);
+      for (size_t k = 0; k < values.size(); ++k)
+      {
+        total += values[k] - cells[k];
+        cells[k] = values[k];
+      }
+    }
+  }
+};
+
+// Single-cell edits on a 1M-cell sheet with four observers
+template <typename ObserverType>
+void benchmarkEdits(bench::Suite &suite, const string &name, bool viaSetData)
+{
+  const size_t cells = 1000000;
+  const size_t edits = max<size_t>(suite.scale(viaSetData ? 200 : 2000), 1);
+  Spreadsheet1 sheet;
+  sheet.setData(vector<int>(cells, 1));
+  deque<ObserverType> observers;
+  for (int i = 0; i < 4; ++i)
+  {
+    ObserverType &o = observers.emplace_back(sheet);
+    o.update();
+    sheet.attach(&o);
+  }
+  vector<int> copy = sheet.getData();
+  suite.runOnce(name, edits, [&]()
+                {
+                  for (size_t e = 0; e < edits; ++e)
+                  {
+                    size_t index = (e * 7919) % cells;
+                    if (viaSetData)
+                    {
+                      copy[index] = int(e);
+                      sheet.setData(copy);
+                    }
+                    else
+                      sheet.setCell(index, int(e));
+                  }
+                })
+      .counter("cells", cells)
+      .counter("observers", observers.size());
+  bench::doNotOptimize(observers.front().total);
+}
+
+int main(int argc, char *argv[])
+{
+  bench::Suite suite("observer", argc, argv);
+
+  Spreadsheet1 sheet;
+  BarChart chart(sheet);
+  Spreadsheet2 mirror(sheet);
+  sheet.attach(&chart);
+  sheet.attach(&mirror);
+  const vector<int> data = {3, 5, 2, 7, 1, 4, 6, 2};
+  {
+    bench::QuietCout quiet;
+    sheet.setData(data);
+  }
+
+  suite.run("Spreadsheet1/notify/observers:2", [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                sheet.notify();
+            });
+  suite.run("Spreadsheet1/setData/observers:2", [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                sheet.setData(data);
+            });
+
+  for (size_t observers : {1, 10, 1000})
+  {
+    benchmarkDispatch(suite, observers, false);
+  }
+  benchmarkDispatch(suite, 10, true);
+
+  benchmarkEdits<SummingObserver>(suite, "edit/setData/cells:1M/observers:4", true);
+  benchmarkEdits<SummingObserver>(suite, "edit/setCell/full-update/cells:1M/observers:4", false);
+  benchmarkEdits<DeltaSummingObserver>(suite, "edit/setCell/delta-update/cells:1M/observers:4", false);
+  return 0;
+}
@@ -0,0 +1,96 @@
+// Prototype benchmarks: clones/sec and heap allocations per clone for heap clone(), pooled spawn() and arena
+// cloneN(), over repeated waves of spawned and destroyed characters
+
+#include "bench.h"
+
+#define DESIGN_PATTERNS_NO_MAIN
+#include "../creational/prototype.cpp"
+
+#include <atomic>
+#include <cstdlib>
+
+// Counts every global allocation made by the process
+static atomic<uint64_t> allocations{0};
+
+void *operator new(size_t bytes)
+{
+  ++allocations;
+  if (void *p = malloc(bytes ? bytes : 1))
+    return p;
+  throw bad_alloc();
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+int main(int argc, char *argv[])
+{
+  bench::Suite suite("prototype", argc, argv);
+  const size_t waveSize = 10000;
+  const size_t waves = suite.scale(100);
+  const uint64_t clones = uint64_t(waveSize) * waves;
+
+  PrototypeRegistry registry;
+  size_t warrior = registry.add("warrior", make_unique<Warrior>("Sword of the Northern Wastes"));
+  size_t mage = registry.add("mage", make_unique<Mage>("Fireball"));
+
+  // Each wave: half warriors, half mages, all destroyed before the next wave
+  {
+    vector<unique_ptr<Character>> wave;
+    wave.reserve(waveSize);
+    auto run = [&]()
+    {
+      for (size_t i = 0; i < waveSize; ++i)
+        wave.push_back(registry.clone(i % 2 ? mage : warrior));
+      wave.clear();
+    };
+    run(); // warm-up, as for the other cases
+    uint64_t before = allocations;
+    suite.runOnce("clone/heap", clones, [&]()
+                  {
+                    for (size_t w = 0; w < waves; ++w)
+                      run();
+                  })
+        .counter("allocs_per_clone", double(allocations - before) / clones);
+  }
+  {
+    vector<PooledCharacter> wave;
+    wave.reserve(waveSize);
+    auto run = [&]()
+    {
+      for (size_t i = 0; i < waveSize; ++i)
+        wave.push_back(registry.spawn(i % 2 ? mage : warrior));
+      wave.clear();
+    };
+    run(); // grows the slabs to one wave
+    uint64_t before = allocations;
+    suite.runOnce("spawn/pooled", clones, [&]()
+                  {
+                    for (size_t w = 0; w < waves; ++w)
+                      run();
+                  })
+        .counter("allocs_per_clone", double(allocations - before) / clones)
+        .counter("slab_slots", registry.slab(warrior).capacity() + registry.slab(mage).capacity());
+  }
+  {
+    CharacterArena arena;
+    vector<Character *> wave;
+    wave.reserve(waveSize);
+    auto run = [&]()
+    {
+      registry.cloneN(warrior, waveSize / 2, arena, wave);
+      registry.cloneN(mage, waveSize / 2, arena, wave);
+      wave.clear();
+      arena.reset();
+    };
+    run(); // grows the arena to one wave
+    uint64_t before = allocations;
+    suite.runOnce("cloneN/arena", clones, [&]()
+                  {
+                    for (size_t w = 0; w < waves; ++w)
+                      run();
+                  })
+        .counter("allocs_per_clone", double(allocations - before) / clones)
+        .counter("arena_bytes", arena.bytesReserved());
+  }
+  return 0;
+}
@@ -0,0 +1,147 @@
+// Proxy benchmarks: request latency (p50/p99) and upstream calls for the lazy proxy against the caching,
+// coalescing proxy under a Zipf-distributed workload with a simulated 1 ms upstream
+
+#include "bench.h"
+
+#define DESIGN_PATTERNS_NO_MAIN
+#include "../structural/proxy.cpp"
+
+#include <atomic>
+#include <cmath>
+#include <random>
+
+using Clock = chrono::steady_clock;
+
+// Upstream stand-in: fixed latency, 4 KB payload, no console output
+class RemoteVideoService : public YouTubeService
+{
+public:
+  static inline atomic<uint64_t> calls{0};
+  string getVideo(const string &videoId) override
+  {
+    ++calls;
+    this_thread::sleep_for(chrono::milliseconds(1));
+    string data(4096, '.');
+    data.replace(0, videoId.size(), videoId);
+    return data;
+  }
+};
+
+// Video ids drawn from Zipf(s) over a catalogue
+vector<string> zipfRequests(size_t count, size_t catalogue, double s, uint32_t seed)
+{
+  vector<double> cdf(catalogue);
+  double sum = 0;
+  for (size_t k = 0; k < catalogue; ++k)
+  {
+    sum += 1.0 / pow(double(k + 1), s);
+    cdf[k] = sum;
+  }
+  mt19937 rng(seed);
+  uniform_real_distribution<double> u(0, sum);
+  vector<string> ids(count);
+  for (auto &id : ids)
+  {
+    size_t k = size_t(lower_bound(cdf.begin(), cdf.end(), u(rng)) - cdf.begin());
+    id = "vid" + to_string(min(k, catalogue - 1));
+  }
+  return ids;
+}
+
+// Runs requests on `clients` threads; returns per-request latencies in microseconds
+template <typename Service>
+vector<double> drive(Service &service, const vector<string> &requests, size_t clients)
+{
+  vector<double> latencies(requests.size());
+  vector<thread> threads;
+  for (size_t c = 0; c < clients; ++c)
+  {
+    threads.emplace_back([&, c]()
+                         {
+                           for (size_t i = c; i < requests.size(); i += clients)
+                           {
+                             auto start = Clock::now();
+                             bench::doNotOptimize(service.getVideo(requests[i]).size());
+                             latencies[i] = chrono::duration<double, micro>(Clock::now() - start).count();
+                           }
+                         });
+  }
+  for (auto &t : threads)
+  {
+    t.join();
+  }
+  return latencies;
+}
+
+int main(int argc, char *argv[])
+{
+  bench::Suite suite("proxy", argc, argv);
+  const size_t catalogue = 10000;
+  const double s = 0.99;
+
+  // Baseline: YouTubeLazyProxy is not thread-safe, so one client; every request goes to a 1 ms YouTubeAPI
+  {
+    vector<string> requests = zipfRequests(suite.scale(1000), catalogue, s, 1);
+    YouTubeLazyProxy lazy(chrono::milliseconds(1));
+    vector<double> latencies;
+    bench::QuietCout quiet;
+    lazy.getVideo("warmup"); // pays the API's construction outside the measurement
+    bench::Result &r = suite.runOnce("lazy/clients:1", requests.size(), [&]()
+                                     { latencies = drive(lazy, requests, 1); });
+    r.counter("p50_us", bench::percentile(latencies, 0.5))
+        .counter("p99_us", bench::percentile(latencies, 0.99))
+        .counter("upstream_calls", double(requests.size()));
+  }
+
+  vector<string> requests = zipfRequests(suite.scale(40000), catalogue, s, 2);
+  CachingProxyOptions options;
+  options.cacheBytes = size_t(8) << 20; // about 2000 of the 10000 videos
+  options.fetchers = 16;
+  options.upstream = []()
+  { return make_unique<RemoteVideoService>(); };
+
+  for (size_t clients : {1, 16})
+  {
+    YouTubeCachingProxy proxy(options);
+    RemoteVideoService::calls = 0;
+    vector<double> latencies;
+    bench::Result &r = suite.runOnce("caching/clients:" + to_string(clients), requests.size(), [&]()
+                                     { latencies = drive(proxy, requests, clients); });
+    CachingProxyStats stats = proxy.stats();
+    r.counter("p50_us", bench::percentile(latencies, 0.5))
+        .counter("p99_us", bench::percentile(latencies, 0.99))
+        .counter("upstream_calls", RemoteVideoService::calls.load())
+        .counter("hit_rate", requests.empty() ? 0 : double(stats.hits) / requests.size())
+        .counter("coalesced", stats.coalesced)
+        .counter("evictions", stats.evictions);
+  }
+
+  // One thread keeps a window of async requests outstanding; optionally hints the next window
+  const size_t window = 256;
+  for (bool hinted : {false, true})
+  {
+    YouTubeCachingProxy proxy(options);
+    RemoteVideoService::calls = 0;
+    bench::Result &r = suite.runOnce(string("caching/async/window:256") + (hinted ? "/prefetch" : ""), requests.size(), [&]()
+                                     {
+                                       vector<shared_future<string>> pending;
+                                       span<const string> all(requests);
+                                       for (size_t i = 0; i < all.size(); i += window)
+                                       {
+                                         span<const string> batch = all.subspan(i, min(window, all.size() - i));
+                                         if (hinted && i + window < all.size())
+                                           proxy.prefetch(all.subspan(i + window, min(window, all.size() - i - window)));
+                                         pending.clear();
+                                         for (const auto &id : batch)
+                                           pending.push_back(proxy.getVideoAsync(id));
+                                         for (auto &f : pending)
+                                           bench::doNotOptimize(f.get().size());
+                                       }
+                                     });
+    CachingProxyStats stats = proxy.stats();
+    r.counter("upstream_calls", RemoteVideoService::calls.load())
+        .counter("prefetches", stats.prefetches)
+        .counter("coalesced", stats.coalesced);
+  }
+  return 0;
+}
@@ -0,0 +1,14 @@
+# Runs every benchmark executable and stores its JSON report as OUTPUT_DIR/<suite>.json
+file(MAKE_DIRECTORY ${OUTPUT_DIR})
+separate_arguments(args UNIX_COMMAND "${BENCH_ARGS}")
+foreach(binary ${BENCHMARKS})
+  get_filename_component(name ${binary} NAME_WE)
+  string(REGEX REPLACE "^bench_" "" suite ${name})
+  message(STATUS "Running ${name}")
+  execute_process(COMMAND ${binary} ${args}
+    OUTPUT_FILE ${OUTPUT_DIR}/${suite}.json
+    RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${name} failed: ${result}")
+  endif()
+endforeach()
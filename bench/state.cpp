@@ -0,0 +1,147 @@
+// State benchmarks: transitions/sec for heap-allocated state objects against the constexpr
+// transition table, one event at a time and through publishAll
+
+#include "bench.h"
+
+#define DESIGN_PATTERNS_NO_MAIN
+#include "../behavioural/state.cpp"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+// Baseline: the previous design, one heap-allocated state object per transition (logging removed)
+class HeapDocument;
+
+class HeapState
+{
+public:
+  virtual ~HeapState() = default;
+  virtual void publish(HeapDocument &doc, UserRole user) = 0;
+  virtual std::string name() const = 0;
+};
+
+class HeapDocument
+{
+  std::unique_ptr<HeapState> state;
+
+public:
+  HeapDocument();
+  void setState(std::unique_ptr<HeapState> newState) { state = std::move(newState); }
+  void publish(UserRole user) { state->publish(*this, user); }
+  std::string getStateName() const { return state->name(); }
+};
+
+class HeapArchived : public HeapState
+{
+public:
+  void publish(HeapDocument &, UserRole) override {}
+  std::string name() const override { return "Archived"; }
+};
+
+class HeapPublished : public HeapState
+{
+public:
+  void publish(HeapDocument &doc, UserRole user) override
+  {
+    if (user == UserRole::Admin)
+      doc.setState(std::make_unique<HeapArchived>());
+  }
+  std::string name() const override { return "Published"; }
+};
+
+class HeapUnderReview : public HeapState
+{
+public:
+  void publish(HeapDocument &doc, UserRole user) override
+  {
+    if (user == UserRole::Moderator || user == UserRole::Admin)
+      doc.setState(std::make_unique<HeapPublished>());
+  }
+  std::string name() const override { return "Under Review"; }
+};
+
+class HeapDraft : public HeapState
+{
+public:
+  void publish(HeapDocument &doc, UserRole user) override
+  {
+    if (user == UserRole::Editor)
+      doc.setState(std::make_unique<HeapUnderReview>());
+    else if (user == UserRole::Admin)
+      doc.setState(std::make_unique<HeapPublished>());
+  }
+  std::string name() const override { return "Draft"; }
+};
+
+HeapDocument::HeapDocument() : state(std::make_unique<HeapDraft>()) {}
+
+void benchmarkTransitions(bench::Suite &suite)
+{
+  const std::size_t documents = suite.scale(1000000);
+  const std::size_t rounds = 4;
+  const std::uint64_t events = std::uint64_t(documents) * rounds;
+
+  // Roles per (round, document); four rounds take most documents through the whole workflow
+  std::mt19937 rng(11);
+  std::vector<std::vector<UserRole>> roles(rounds, std::vector<UserRole>(documents));
+  for (auto &round : roles)
+  {
+    for (auto &role : round)
+      role = UserRole(rng() % roleCount);
+  }
+
+  suite.runOnce("heap-states/publish", events, [&]()
+                {
+                  std::vector<HeapDocument> docs(documents);
+                  for (const auto &round : roles)
+                  {
+                    for (std::size_t i = 0; i < documents; ++i)
+                      docs[i].publish(round[i]);
+                  }
+                  bench::doNotOptimize(docs.back().getStateName());
+                });
+
+  std::vector<Document> docs(documents, Document("Doc"));
+  std::size_t changed = 0;
+  suite.runOnce("table/publish/logged", events, [&]()
+                {
+                  std::ostream &sink = bench::nullStream();
+                  for (const auto &round : roles)
+                  {
+                    for (std::size_t i = 0; i < documents; ++i)
+                      docs[i].publish(round[i], sink);
+                  }
+                  bench::doNotOptimize(docs.back().getStateName());
+                });
+
+  for (auto &d : docs)
+    d.setState(DocumentState::Draft);
+  suite.runOnce("table/advance", events, [&]()
+                {
+                  for (const auto &round : roles)
+                  {
+                    for (std::size_t i = 0; i < documents; ++i)
+                      changed += docs[i].advance(round[i]);
+                  }
+                  bench::doNotOptimize(changed);
+                });
+
+  for (auto &d : docs)
+    d.setState(DocumentState::Draft);
+  changed = 0;
+  suite.runOnce("table/publishAll", events, [&]()
+                {
+                  for (const auto &round : roles)
+                    changed += publishAll(docs, round);
+                })
+      .counter("state_changes", changed)
+      .counter("bytes_per_state", sizeof(DocumentState));
+}
+
+int main(int argc, char *argv[])
+{
+  bench::Suite suite("state", argc, argv);
+  benchmarkTransitions(suite);
+  return 0;
+}
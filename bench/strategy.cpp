@@ -0,0 +1,86 @@
+// Strategy benchmarks: VideoStorage over a multi-GB synthetic video, streaming block pipeline against whole-file
+// processing; reports MB/s and the peak RSS of each case
+
+#include "bench.h"
+
+#define DESIGN_PATTERNS_NO_MAIN
+#include "../behavioural/strategy.cpp"
+
+#include <fstream>
+
+// Resets the kernel's peak-RSS mark so each case reports its own peak; false if the kernel does not support it
+bool resetPeakRss()
+{
+  std::ofstream clear("/proc/self/clear_refs");
+  clear << "5";
+  return bool(clear.flush());
+}
+
+double peakRssMegabytes()
+{
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line))
+  {
+    if (line.rfind("VmHWM:", 0) == 0)
+      return std::stod(line.substr(6)) / 1024;
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[])
+{
+  bench::Suite suite("strategy", argc, argv);
+  const std::uint64_t bytes = std::uint64_t(suite.scale(2048)) << 20;
+  const double megabytes = double(bytes) / (1 << 20);
+  std::filesystem::path directory = std::filesystem::temp_directory_path() / "strategy_bench_videos";
+  std::filesystem::create_directories(directory);
+  const std::string input = (directory / "input.raw").string();
+  const std::string output = (directory / "output.stored").string();
+  writeSampleVideo(input, bytes);
+  bool peakIsPerCase = resetPeakRss();
+
+  auto measure = [&](const std::string &name, auto store)
+  {
+    resetPeakRss();
+    StoreStats stats;
+    bench::Result &result = suite.runOnce(name, bytes, [&]()
+                                          { stats = store(); });
+    result.counter("mb_per_sec", result.seconds > 0 ? megabytes / result.seconds : 0)
+        .counter("peak_rss_mb", peakRssMegabytes())
+        .counter("peak_rss_per_case", peakIsPerCase)
+        .counter("compression_ratio", stats.bytesOut ? double(stats.bytesIn) / double(stats.bytesOut) : 0);
+    std::filesystem::remove(output);
+  };
+
+  VideoStorage storage(std::make_unique<H264Compression>(), std::make_unique<WatermarkOverlay>());
+  std::size_t maxWorkers = std::max(4u, std::thread::hardware_concurrency());
+  for (std::size_t workers = 1; workers <= maxWorkers; workers *= 2)
+  {
+    StreamOptions options;
+    options.workers = workers;
+    measure("storeVideo/streaming/workers:" + std::to_string(workers), [&]()
+            { return storage.storeVideo(input, output, options); });
+  }
+  for (std::size_t blockKb : {64, 256, 4096})
+  {
+    StreamOptions options;
+    options.blockBytes = blockKb << 10;
+    measure("storeVideo/streaming/block:" + std::to_string(blockKb) + "KB", [&]()
+            { return storage.storeVideo(input, output, options); });
+  }
+  measure("storeVideo/wholeFile", [&]()
+          { return storage.storeVideoWholeFile(input, output); });
+
+  storage.setOverlayStrategy(std::make_unique<TimestampOverlay>());
+  storage.setCompressionStrategy(std::make_unique<VP9Compression>());
+  measure("storeVideo/streaming/VP9+timestamp", [&]()
+          { return storage.storeVideo(input, output); });
+  storage.setOverlayStrategy(std::make_unique<NoOverlay>());
+  storage.setCompressionStrategy(std::make_unique<ZipCompression>());
+  measure("storeVideo/streaming/ZIP", [&]()
+          { return storage.storeVideo(input, output); });
+
+  std::filesystem::remove_all(directory);
+  return 0;
+}
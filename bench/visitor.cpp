@@ -0,0 +1,123 @@
+// Visitor benchmarks: accept() double dispatch over a mixed shape list, and area/perimeter totals over
+// 10M mixed shapes as heap objects, a type-sorted ShapeCollection and a vector of std::variant, and the
+// scaling of parallelVisit from 1 to 64 threads
+
+#include "bench.h"
+
+#define DESIGN_PATTERNS_NO_MAIN
+#include "../behavioural/visitor.cpp"
+
+#include <cstring>
+#include <memory>
+#include <random>
+
+void benchmarkDispatch(bench::Suite &suite)
+{
+  vector<unique_ptr<Shape>> shapes;
+  for (int i = 0; i < 1000; ++i)
+  {
+    if (i % 2)
+      shapes.push_back(make_unique<Circle>(1.0 + i % 7));
+    else
+      shapes.push_back(make_unique<Rectangle>(1.0 + i % 5, 2.0 + i % 3));
+  }
+  AreaVisitor area;
+  PerimeterVisitor perimeter;
+  suite.run("Shape/accept/AreaVisitor", [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                shapes[i % shapes.size()]->accept(area);
+            });
+  suite.run("Shape/accept/PerimeterVisitor", [&](uint64_t n)
+            {
+              for (uint64_t i = 0; i < n; ++i)
+                shapes[i % shapes.size()]->accept(perimeter);
+            });
+}
+
+// Mixed shapes in random order, as they would arrive from a scene file
+void benchmarkLayouts(bench::Suite &suite)
+{
+  const size_t count = suite.scale(10000000);
+  vector<ShapeValue> values;
+  values.reserve(count);
+  mt19937 rng(3);
+  uniform_real_distribution<double> size(0.5, 10.0);
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (rng() % 2)
+      values.emplace_back(Circle(size(rng)));
+    else
+      values.emplace_back(Rectangle(size(rng), size(rng)));
+  }
+
+  {
+    vector<unique_ptr<Shape>> shapes;
+    shapes.reserve(count);
+    for (const auto &v : values)
+    {
+      if (auto *c = get_if<Circle>(&v))
+        shapes.push_back(make_unique<Circle>(*c));
+      else
+        shapes.push_back(make_unique<Rectangle>(get<Rectangle>(v)));
+    }
+    TotalsVisitor totals;
+    suite.runOnce("totals/virtual/TotalsVisitor", count, [&]()
+                  {
+                    for (auto &shape : shapes)
+                      shape->accept(totals);
+                  })
+        .counter("area", totals.totals.area);
+  }
+
+  ShapeTotals variantTotals;
+  suite.runOnce("totals/variant/measure", count, [&]()
+                { variantTotals = measure(values); })
+      .counter("area", variantTotals.area)
+      .counter("bytes_per_shape", sizeof(ShapeValue));
+
+  ShapeCollection collection;
+  for (const auto &v : values)
+  {
+    visit([&](const auto &shape)
+          { collection.add(shape); },
+          v);
+  }
+  values.clear();
+  values.shrink_to_fit();
+  AreaBatchVisitor area;
+  PerimeterBatchVisitor perimeter;
+  AreaPerimeterBatchVisitor fused;
+  suite.runOnce("totals/soa/AreaBatchVisitor", count, [&]()
+                { collection.accept(area); });
+  suite.runOnce("totals/soa/PerimeterBatchVisitor", count, [&]()
+                { collection.accept(perimeter); });
+  suite.runOnce("totals/soa/AreaPerimeterBatchVisitor", count, [&]()
+                { collection.accept(fused); })
+      .counter("area", fused.totals.area)
+      .counter("bytes_per_shape", double(collection.circleCount() * 8 + collection.rectangleCount() * 16) / count);
+
+  // Scaling curve; "deterministic" is 1 when the totals are bit-identical to the one-thread run
+  ShapeTotals serial;
+  for (size_t threads = 1; threads <= 64; threads *= 2)
+  {
+    ThreadPool pool(threads);
+    ShapeTotals totals;
+    suite.runOnce("parallelVisit/AreaPerimeterBatchVisitor/threads:" + to_string(threads), count, [&]()
+                  { totals = parallelVisit<AreaPerimeterBatchVisitor>(collection, pool).totals; })
+        .counter("threads", threads)
+        .counter("area", totals.area)
+        .counter("deterministic", threads == 1 || (memcmp(&totals.area, &serial.area, sizeof(double)) == 0 &&
+                                                   memcmp(&totals.perimeter, &serial.perimeter, sizeof(double)) == 0));
+    if (threads == 1)
+      serial = totals;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  bench::Suite suite("visitor", argc, argv);
+  benchmarkDispatch(suite);
+  benchmarkLayouts(suite);
+  return 0;
+}
@@ -19,11 +19,29 @@ Example: Game Characters
 ------------------------
 Suppose you are building a game where you have different types of characters (e.g., Warrior, Mage). Instead of creating each character from scratch, you can define prototypes for each type and clone them to create new characters.
 
+Pooled and Arena Clones:
+- The immutable parts of a character (weapon, spell) are held by shared_ptr<const string>, so a clone shares them
+  with its prototype instead of copying the string.
+- cloneInto(storage) copies a character into memory supplied by the caller; storageSize() says how much it needs.
+- PrototypeRegistry keeps named prototypes, each with its own slab of fixed-size slots. spawn() clones into a
+  slot and returns a handle that gives the slot back when destroyed, so freed slots are recycled and a steady
+  stream of spawns and deaths allocates nothing once the slab has grown.
+- cloneN(id, count, arena, out) bulk-clones into a CharacterArena, a bump allocator whose reset() destroys the
+  whole wave at once and keeps its memory for the next one.
+- The registry, its slabs and arenas are meant for one thread, such as the game loop.
+
 */
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <vector>
+#include <map>
+#include <new>
+#include <cstddef>
+#include <stdexcept>
+#include <functional>
 using namespace std;
 
 // Prototype interface
@@ -31,6 +49,9 @@ class Character
 {
 public:
   virtual unique_ptr<Character> clone() const = 0;
+  // Copy constructs this character in storage of at least storageSize() bytes
+  virtual Character *cloneInto(void *storage) const = 0;
+  virtual size_t storageSize() const = 0;
   virtual void display() const = 0;
   virtual ~Character() {}
 };
@@ -38,37 +59,235 @@ public:
 // ConcretePrototype: Warrior
 class Warrior : public Character
 {
-  string weapon;
+  shared_ptr<const string> weapon;
 
 public:
-  Warrior(const string &w) : weapon(w) {}
+  Warrior(const string &w) : weapon(make_shared<const string>(w)) {}
   unique_ptr<Character> clone() const override
   {
     return make_unique<Warrior>(*this);
   }
+  Character *cloneInto(void *storage) const override
+  {
+    return new (storage) Warrior(*this);
+  }
+  size_t storageSize() const override { return sizeof(Warrior); }
   void display() const override
   {
-    cout << "Warrior with " << weapon << endl;
+    cout << "Warrior with " << *weapon << endl;
   }
 };
 
 // ConcretePrototype: Mage
 class Mage : public Character
 {
-  string spell;
+  shared_ptr<const string> spell;
 
 public:
-  Mage(const string &s) : spell(s) {}
+  Mage(const string &s) : spell(make_shared<const string>(s)) {}
   unique_ptr<Character> clone() const override
   {
     return make_unique<Mage>(*this);
   }
+  Character *cloneInto(void *storage) const override
+  {
+    return new (storage) Mage(*this);
+  }
+  size_t storageSize() const override { return sizeof(Mage); }
   void display() const override
   {
-    cout << "Mage casting " << spell << endl;
+    cout << "Mage casting " << *spell << endl;
+  }
+};
+
+constexpr size_t characterAlignment = alignof(max_align_t);
+
+constexpr size_t alignedSize(size_t bytes)
+{
+  return (bytes + characterAlignment - 1) / characterAlignment * characterAlignment;
+}
+
+// Fixed-size slots carved from chunks; freed slots go on an intrusive free list
+class CharacterSlab
+{
+  size_t slotSize;
+  size_t slotsPerChunk;
+  vector<unique_ptr<byte[]>> chunks;
+  void *freeList = nullptr;
+  size_t live = 0;
+
+  void grow()
+  {
+    chunks.push_back(make_unique<byte[]>(slotSize * slotsPerChunk));
+    byte *chunk = chunks.back().get();
+    for (size_t i = slotsPerChunk; i-- > 0;)
+    {
+      void *slot = chunk + i * slotSize;
+      *static_cast<void **>(slot) = freeList;
+      freeList = slot;
+    }
+  }
+
+public:
+  CharacterSlab(size_t objectSize, size_t slotsPerChunk = 256)
+      : slotSize(alignedSize(max(objectSize, sizeof(void *)))), slotsPerChunk(slotsPerChunk) {}
+  CharacterSlab(const CharacterSlab &) = delete;
+  CharacterSlab &operator=(const CharacterSlab &) = delete;
+
+  void *allocate()
+  {
+    if (!freeList)
+      grow();
+    void *slot = freeList;
+    freeList = *static_cast<void **>(slot);
+    ++live;
+    return slot;
+  }
+  void release(void *slot)
+  {
+    *static_cast<void **>(slot) = freeList;
+    freeList = slot;
+    --live;
+  }
+  size_t liveCount() const { return live; }
+  size_t capacity() const { return chunks.size() * slotsPerChunk; }
+};
+
+// Destroys a pooled character and returns its slot to the slab
+struct SlabDeleter
+{
+  CharacterSlab *slab = nullptr;
+  void operator()(Character *character) const
+  {
+    void *slot = dynamic_cast<void *>(character);
+    character->~Character();
+    slab->release(slot);
+  }
+};
+
+using PooledCharacter = unique_ptr<Character, SlabDeleter>;
+
+// Bump allocator for a wave of clones; reset() destroys them all and keeps the memory
+class CharacterArena
+{
+  size_t chunkBytes;
+  vector<unique_ptr<byte[]>> chunks;
+  size_t current = 0; // chunk being filled
+  size_t offset = 0;
+  vector<Character *> objects; // destroyed in reverse order by reset()
+
+  void *allocate(size_t bytes)
+  {
+    bytes = alignedSize(bytes);
+    if (bytes > chunkBytes)
+      throw length_error("CharacterArena: object larger than a chunk");
+    if (chunks.empty() || offset + bytes > chunkBytes)
+    {
+      if (!chunks.empty())
+        ++current;
+      if (current == chunks.size())
+        chunks.push_back(make_unique<byte[]>(chunkBytes));
+      offset = 0;
+    }
+    void *p = chunks[current].get() + offset;
+    offset += bytes;
+    return p;
   }
+
+public:
+  explicit CharacterArena(size_t chunkBytes = size_t(1) << 20) : chunkBytes(chunkBytes) {}
+  ~CharacterArena() { reset(); }
+  CharacterArena(const CharacterArena &) = delete;
+  CharacterArena &operator=(const CharacterArena &) = delete;
+
+  // Appends count clones of prototype to out; they live until reset()
+  void cloneN(const Character &prototype, size_t count, vector<Character *> &out)
+  {
+    size_t bytes = prototype.storageSize();
+    objects.reserve(objects.size() + count);
+    for (size_t i = 0; i < count; ++i)
+    {
+      Character *clone = prototype.cloneInto(allocate(bytes));
+      objects.push_back(clone);
+      out.push_back(clone);
+    }
+  }
+
+  void reset()
+  {
+    for (size_t i = objects.size(); i-- > 0;)
+    {
+      objects[i]->~Character();
+    }
+    objects.clear();
+    current = 0;
+    offset = 0;
+  }
+
+  size_t size() const { return objects.size(); }
+  size_t bytesReserved() const { return chunks.size() * chunkBytes; }
 };
 
+// Named prototypes, each with a slab for pooled clones; spawned characters must not outlive the registry
+class PrototypeRegistry
+{
+  struct Entry
+  {
+    unique_ptr<Character> prototype;
+    unique_ptr<CharacterSlab> slab;
+  };
+  vector<Entry> entries;
+  map<string, size_t, less<>> ids;
+
+public:
+  size_t add(const string &name, unique_ptr<Character> prototype)
+  {
+    if (ids.count(name))
+      throw invalid_argument("PrototypeRegistry: '" + name + "' is already registered");
+    auto slab = make_unique<CharacterSlab>(prototype->storageSize());
+    entries.push_back({std::move(prototype), std::move(slab)});
+    ids.emplace(name, entries.size() - 1);
+    return entries.size() - 1;
+  }
+
+  size_t find(string_view name) const
+  {
+    auto it = ids.find(name);
+    if (it == ids.end())
+      throw out_of_range("PrototypeRegistry: no prototype named '" + string(name) + "'");
+    return it->second;
+  }
+
+  const Character &prototype(size_t id) const { return *entries.at(id).prototype; }
+
+  // Heap clone, as Character::clone()
+  unique_ptr<Character> clone(size_t id) const { return entries.at(id).prototype->clone(); }
+
+  // Clone in a recycled slot of the prototype's slab
+  PooledCharacter spawn(size_t id)
+  {
+    Entry &entry = entries.at(id);
+    void *slot = entry.slab->allocate();
+    try
+    {
+      return PooledCharacter(entry.prototype->cloneInto(slot), SlabDeleter{entry.slab.get()});
+    }
+    catch (...)
+    {
+      entry.slab->release(slot);
+      throw;
+    }
+  }
+
+  void cloneN(size_t id, size_t count, CharacterArena &arena, vector<Character *> &out) const
+  {
+    arena.cloneN(*entries.at(id).prototype, count, out);
+  }
+
+  const CharacterSlab &slab(size_t id) const { return *entries.at(id).slab; }
+};
+
+#ifndef DESIGN_PATTERNS_NO_MAIN
 int main()
 {
   // Create prototypes
@@ -85,5 +304,30 @@ int main()
   warrior2->display();
   mage1->display();
 
+  // Pooled spawning: a freed slot is handed to the next spawn of the same type
+  PrototypeRegistry registry;
+  size_t warriorId = registry.add("warrior", make_unique<Warrior>("Axe"));
+  size_t mageId = registry.add("mage", make_unique<Mage>("Frostbolt"));
+  cout << "\nPooled:" << endl;
+  PooledCharacter pooled = registry.spawn(warriorId);
+  pooled->display();
+  const void *slot = pooled.get();
+  pooled.reset();
+  pooled = registry.spawn(registry.find("warrior"));
+  cout << "Slot reused: " << (pooled.get() == slot ? "yes" : "no") << ", live warriors: "
+       << registry.slab(warriorId).liveCount() << endl;
+
+  // Arena wave: three mages at once, destroyed together
+  CharacterArena arena;
+  vector<Character *> wave;
+  registry.cloneN(mageId, 3, arena, wave);
+  cout << "\nArena wave of " << wave.size() << ":" << endl;
+  for (const Character *c : wave)
+  {
+    c->display();
+  }
+  arena.reset();
+
   return 0;
-}
\ No newline at end of file
+}
+#endif
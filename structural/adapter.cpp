@@ -19,10 +19,19 @@ Example: Video Editing App (Color Interface)
 -------------------------------------------
 Suppose you are building a video editing app that expects to use a `Color` interface to change a video's colors. However, you have a third-party or legacy class called `LegacyColorFilter` with a different interface. You want to use this class without modifying it, so you create an adapter.
 
+Block Batches:
+- Color::applyColor also takes a span of video files; by default it makes one call per file.
+- ColorAdapter forwards a whole batch to LegacyColorFilter::changeColors in one call, and frame pixels to
+  LegacyColorFilter::tintBlock, so a block of frames costs one virtual call instead of one per pixel or file.
+- tintBlock is a plain loop over packed 0xRRGGBB pixels that the compiler vectorizes.
+
 */
 
 #include <iostream>
 #include <string>
+#include <span>
+#include <vector>
+#include <cstdint>
 using namespace std;
 
 // Target interface
@@ -30,6 +39,15 @@ class Color
 {
 public:
   virtual void applyColor(const string &videoFile) = 0;
+  virtual void applyColor(span<const string> videoFiles)
+  {
+    for (const auto &videoFile : videoFiles)
+    {
+      applyColor(videoFile);
+    }
+  }
+  // Tints a block of packed 0xRRGGBB pixels in place
+  virtual void applyColorToBlock(span<uint32_t> pixels) = 0;
   virtual ~Color() {}
 };
 
@@ -41,6 +59,24 @@ public:
   {
     cout << "[LegacyColorFilter] Changing color of '" << fileName << "' to RGB: " << rgb << endl;
   }
+  void changeColors(span<const string> fileNames, int rgb)
+  {
+    cout << "[LegacyColorFilter] Changing color of " << fileNames.size() << " videos to RGB: " << rgb << ":";
+    for (const auto &fileName : fileNames)
+    {
+      cout << " '" << fileName << "'";
+    }
+    cout << endl;
+  }
+  // Averages every pixel with rgb, channel by channel
+  void tintBlock(span<uint32_t> pixels, int rgb)
+  {
+    uint32_t tint = (uint32_t(rgb) >> 1) & 0x7F7F7F;
+    for (auto &pixel : pixels)
+    {
+      pixel = ((pixel >> 1) & 0x7F7F7F) + tint;
+    }
+  }
 };
 
 // Adapter
@@ -56,6 +92,14 @@ public:
     // Adapts the call to the legacy interface
     legacyFilter->changeColor(videoFile, rgbValue);
   }
+  void applyColor(span<const string> videoFiles) override
+  {
+    legacyFilter->changeColors(videoFiles, rgbValue);
+  }
+  void applyColorToBlock(span<uint32_t> pixels) override
+  {
+    legacyFilter->tintBlock(pixels, rgbValue);
+  }
 };
 
 // Client code (Video Editor)
@@ -66,6 +110,14 @@ public:
   {
     color->applyColor(videoFile);
   }
+  void changeVideoColors(Color *color, span<const string> videoFiles)
+  {
+    color->applyColor(videoFiles);
+  }
+  void changeFrameColor(Color *color, span<uint32_t> pixels)
+  {
+    color->applyColorToBlock(pixels);
+  }
 };
 
 int main()
@@ -84,5 +136,14 @@ int main()
   ColorAdapter redAdapter(&legacyFilter, 16711680); // 16711680 = red
   editor.changeVideoColor(&redAdapter, video);
 
+  // A batch of videos goes to the legacy filter in one call
+  vector<string> playlist = {"holiday.mp4", "lecture.webm", "archive.avi"};
+  editor.changeVideoColors(&blueAdapter, playlist);
+
+  // So does a block of frame pixels
+  vector<uint32_t> frame(1920 * 1080, 0xFFFFFF);
+  editor.changeFrameColor(&redAdapter, frame);
+  cout << "First pixel after red tint: 0x" << hex << frame[0] << dec << endl;
+
   return 0;
 }
\ No newline at end of file
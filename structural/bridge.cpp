@@ -24,12 +24,32 @@ Suppose you are building a system for remote controls and electronic devices. Yo
 - RefinedAbstraction: AdvancedRemoteControl
 - ConcreteImplementor: TV, Radio
 
+Command Batches:
+- RemoteControl::send hands a whole span of DeviceCommands to the device in one call, as a remote sends a burst
+  of codes, instead of one virtual call per button press.
+- Device::execute dispatches each command to turnOn/turnOff/setChannel by default.
+- TV and Radio override it to format the whole batch into one buffer and write it with a single stream call.
+
 */
 
 #include <iostream>
 #include <string>
+#include <span>
+#include <vector>
 using namespace std;
 
+struct DeviceCommand
+{
+  enum class Type
+  {
+    TurnOn,
+    TurnOff,
+    SetChannel
+  };
+  Type type;
+  int channel = 0;
+};
+
 // Implementor
 class Device
 {
@@ -37,9 +57,50 @@ public:
   virtual void turnOn() = 0;
   virtual void turnOff() = 0;
   virtual void setChannel(int channel) = 0;
+  virtual void execute(span<const DeviceCommand> commands)
+  {
+    for (const auto &command : commands)
+    {
+      switch (command.type)
+      {
+      case DeviceCommand::Type::TurnOn:
+        turnOn();
+        break;
+      case DeviceCommand::Type::TurnOff:
+        turnOff();
+        break;
+      case DeviceCommand::Type::SetChannel:
+        setChannel(command.channel);
+        break;
+      }
+    }
+  }
   virtual ~Device() {}
 };
 
+// Formats a batch in the device's own wording, one line per command
+string describeCommands(span<const DeviceCommand> commands, const string &on, const string &off, const string &channel)
+{
+  string text;
+  for (const auto &command : commands)
+  {
+    switch (command.type)
+    {
+    case DeviceCommand::Type::TurnOn:
+      text += on;
+      break;
+    case DeviceCommand::Type::TurnOff:
+      text += off;
+      break;
+    case DeviceCommand::Type::SetChannel:
+      text += channel + to_string(command.channel);
+      break;
+    }
+    text += '\n';
+  }
+  return text;
+}
+
 // ConcreteImplementor: TV
 class TV : public Device
 {
@@ -56,6 +117,10 @@ public:
   {
     cout << "TV channel set to " << channel << endl;
   }
+  void execute(span<const DeviceCommand> commands) override
+  {
+    cout << describeCommands(commands, "TV is ON", "TV is OFF", "TV channel set to ") << flush;
+  }
 };
 
 // ConcreteImplementor: Radio
@@ -74,6 +139,10 @@ public:
   {
     cout << "Radio station set to " << channel << endl;
   }
+  void execute(span<const DeviceCommand> commands) override
+  {
+    cout << describeCommands(commands, "Radio is ON", "Radio is OFF", "Radio station set to ") << flush;
+  }
 };
 
 // Abstraction
@@ -96,6 +165,10 @@ public:
   {
     device->setChannel(channel);
   }
+  virtual void send(span<const DeviceCommand> commands)
+  {
+    device->execute(commands);
+  }
   virtual ~RemoteControl() {}
 };
 
@@ -129,5 +202,13 @@ int main()
   advancedRemote.mute();
   advancedRemote.turnOff();
 
+  cout << "\nSending a batch of commands to the TV:" << endl;
+  vector<DeviceCommand> burst = {
+      {DeviceCommand::Type::TurnOn},
+      {DeviceCommand::Type::SetChannel, 7},
+      {DeviceCommand::Type::SetChannel, 12},
+      {DeviceCommand::Type::TurnOff}};
+  basicRemote.send(burst);
+
   return 0;
 }
\ No newline at end of file
@@ -22,20 +22,227 @@ We will model an Amazon package:
 - `Box` is a composite that can contain items and/or other boxes.
 - The client can treat both items and boxes uniformly (e.g., to calculate total price or print contents).
 
+Flattened Package Tree:
+-----------------------
+`Box::getPrice()` walks the whole subtree through virtual calls and shared_ptr hops on every call,
+which is slow for warehouse manifests with hundreds of thousands of items.
+- `PackageTree` flattens a component tree into one preorder array; a box's descendants are the
+  contiguous range right after it, and every box caches its subtotal, so `getPrice()` is a lookup.
+- `setPrice()` and `add()` only update the subtotals on the path from the changed node to the root.
+- `add()` splices the new nodes into the array, so node indices after the insertion point shift.
+- Benchmarks for deep and wide trees live in bench/composite.cpp.
+
+Parallel Aggregation:
+---------------------
+- `Box::getPriceParallel(executor)` splits a large box into chunks of about `threshold` nodes, runs
+  them on a work-stealing pool and adds the partial sums in child order, so the result is repeatable.
+- Boxes smaller than the threshold fall back to the serial `getPrice()`.
+- `printContentsParallel()` renders each chunk into its own buffer and writes the buffers in order.
+- Printing appends to one buffer and grows a single prefix string in place instead of allocating
+  `prefix + "  "` at every level.
+
 */
 
 #include <iostream>
 #include <vector>
 #include <string>
 #include <memory>
+#include <cstdint>
+#include <stdexcept>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <utility>
+#include <algorithm>
 using namespace std;
 
+class PackageTree;
+
+// Thread pool with one task deque per worker: owners pop newest work, idle workers steal the oldest
+class WorkStealingExecutor
+{
+  struct Queue
+  {
+    mutex lock;
+    deque<function<void()>> tasks;
+  };
+
+  vector<unique_ptr<Queue>> queues; // one per worker, plus a shared one for outside threads
+  vector<thread> workers;
+  atomic<size_t> queued{0};
+  atomic<bool> stopping{false};
+  mutex sleepLock;
+  condition_variable wakeup;
+
+  static inline thread_local WorkStealingExecutor *currentExecutor = nullptr;
+  static inline thread_local size_t currentQueue = 0;
+
+  size_t ownQueue() const
+  {
+    return currentExecutor == this ? currentQueue : queues.size() - 1;
+  }
+
+  bool popFrom(size_t index, bool newest, function<void()> &task)
+  {
+    Queue &queue = *queues[index];
+    lock_guard<mutex> guard(queue.lock);
+    if (queue.tasks.empty())
+      return false;
+    if (newest)
+    {
+      task = move(queue.tasks.back());
+      queue.tasks.pop_back();
+    }
+    else
+    {
+      task = move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    --queued;
+    return true;
+  }
+
+  void workerLoop(size_t index)
+  {
+    currentExecutor = this;
+    currentQueue = index;
+    while (!stopping)
+    {
+      if (runOne())
+        continue;
+      unique_lock<mutex> guard(sleepLock);
+      wakeup.wait(guard, [this]()
+                  { return stopping || queued > 0; });
+    }
+  }
+
+public:
+  explicit WorkStealingExecutor(size_t threads = thread::hardware_concurrency())
+  {
+    threads = max<size_t>(threads, 1);
+    for (size_t i = 0; i <= threads; ++i)
+    {
+      queues.push_back(make_unique<Queue>());
+    }
+    for (size_t i = 0; i < threads; ++i)
+    {
+      workers.emplace_back(&WorkStealingExecutor::workerLoop, this, i);
+    }
+  }
+  ~WorkStealingExecutor()
+  {
+    {
+      lock_guard<mutex> guard(sleepLock);
+      stopping = true;
+    }
+    wakeup.notify_all();
+    for (auto &worker : workers)
+    {
+      worker.join();
+    }
+  }
+  WorkStealingExecutor(const WorkStealingExecutor &) = delete;
+  WorkStealingExecutor &operator=(const WorkStealingExecutor &) = delete;
+
+  size_t threadCount() const { return workers.size(); }
+
+  void submit(function<void()> task)
+  {
+    {
+      Queue &queue = *queues[ownQueue()];
+      lock_guard<mutex> guard(queue.lock);
+      queue.tasks.push_back(move(task));
+    }
+    {
+      lock_guard<mutex> guard(sleepLock);
+      ++queued;
+    }
+    wakeup.notify_one();
+  }
+
+  // Runs one pending task, own queue first, then stolen; false if nothing was available
+  bool runOne()
+  {
+    function<void()> task;
+    size_t own = ownQueue();
+    bool found = popFrom(own, true, task);
+    for (size_t i = 1; !found && i < queues.size(); ++i)
+    {
+      found = popFrom((own + i) % queues.size(), false, task);
+    }
+    if (found)
+      task();
+    return found;
+  }
+};
+
+// Fork-join helper: wait() runs pending tasks instead of blocking, so nested groups cannot deadlock
+class TaskGroup
+{
+  WorkStealingExecutor &executor;
+  atomic<size_t> remaining{0};
+  mutex errorLock;
+  exception_ptr error;
+
+public:
+  explicit TaskGroup(WorkStealingExecutor &e) : executor(e) {}
+  ~TaskGroup()
+  {
+    while (remaining > 0)
+    {
+      if (!executor.runOne())
+        this_thread::yield();
+    }
+  }
+
+  void run(function<void()> task)
+  {
+    ++remaining;
+    executor.submit([this, task = move(task)]()
+                    {
+                      try
+                      {
+                        task();
+                      }
+                      catch (...)
+                      {
+                        lock_guard<mutex> guard(errorLock);
+                        if (!error)
+                          error = current_exception();
+                      }
+                      --remaining;
+                    });
+  }
+
+  void wait()
+  {
+    while (remaining > 0)
+    {
+      if (!executor.runOne())
+        this_thread::yield();
+    }
+    if (error)
+      rethrow_exception(exchange(error, nullptr));
+  }
+};
+
 // Component
 class PackageComponent
 {
 public:
   virtual void printContents(const string &prefix = "") const = 0;
   virtual double getPrice() const = 0;
+  // Appends this component and its children to the tree in preorder
+  virtual void flattenInto(PackageTree &tree) const = 0;
+  // Appends the printContents() text to out; prefix is restored before returning
+  virtual void appendContents(string &out, string &prefix) const = 0;
+  // Nodes in this subtree as of the last add(); used only to size parallel work
+  virtual size_t nodeCount() const { return 1; }
   virtual ~PackageComponent() {}
 };
 
@@ -55,6 +262,13 @@ public:
   {
     return price;
   }
+  void flattenInto(PackageTree &tree) const override;
+  void appendContents(string &out, string &prefix) const override
+  {
+    char text[32];
+    snprintf(text, sizeof(text), "%g", price); // same digits as the default ostream format
+    out.append(prefix).append("Item: ").append(name).append(" ($").append(text).append(")\n");
+  }
 };
 
 // Composite: Box
@@ -62,20 +276,112 @@ class Box : public PackageComponent
 {
   string label;
   vector<shared_ptr<PackageComponent>> contents;
+  size_t nodes = 1;
+
+  // A run of small children, or a single child box big enough to split further
+  struct Chunk
+  {
+    size_t begin, end;
+    const Box *box;
+  };
+
+  vector<Chunk> split(size_t threshold) const
+  {
+    vector<Chunk> chunks;
+    size_t begin = 0, weight = 0;
+    for (size_t i = 0; i < contents.size(); ++i)
+    {
+      size_t w = contents[i]->nodeCount();
+      const Box *box = w >= threshold ? dynamic_cast<const Box *>(contents[i].get()) : nullptr;
+      if (box)
+      {
+        if (begin < i)
+          chunks.push_back({begin, i, nullptr});
+        chunks.push_back({i, i + 1, box});
+        begin = i + 1;
+        weight = 0;
+        continue;
+      }
+      weight += w;
+      if (weight >= threshold)
+      {
+        chunks.push_back({begin, i + 1, nullptr});
+        begin = i + 1;
+        weight = 0;
+      }
+    }
+    if (begin < contents.size())
+      chunks.push_back({begin, contents.size(), nullptr});
+    return chunks;
+  }
+
+  void appendContentsParallel(string &out, string &prefix, WorkStealingExecutor &executor,
+                              size_t threshold) const
+  {
+    if (nodes < threshold)
+    {
+      appendContents(out, prefix);
+      return;
+    }
+    out.append(prefix).append("Box: ").append(label).append("\n");
+    vector<Chunk> chunks = split(threshold);
+    vector<string> buffers(chunks.size());
+    string childPrefix = prefix + "  ";
+    TaskGroup group(executor);
+    for (size_t k = 0; k < chunks.size(); ++k)
+    {
+      group.run([this, &chunks, &buffers, &childPrefix, &executor, threshold, k]()
+                {
+                  const Chunk &chunk = chunks[k];
+                  string chunkPrefix = childPrefix;
+                  if (chunk.box)
+                  {
+                    chunk.box->appendContentsParallel(buffers[k], chunkPrefix, executor, threshold);
+                    return;
+                  }
+                  for (size_t i = chunk.begin; i < chunk.end; ++i)
+                    contents[i]->appendContents(buffers[k], chunkPrefix);
+                });
+    }
+    group.wait();
+    for (const auto &buffer : buffers)
+    {
+      out += buffer;
+    }
+  }
 
 public:
+  static constexpr size_t defaultThreshold = 16384;
+
   Box(const string &l) : label(l) {}
   void add(const shared_ptr<PackageComponent> &component)
   {
     contents.push_back(component);
+    nodes += component->nodeCount();
   }
+  size_t nodeCount() const override { return nodes; }
   void printContents(const string &prefix = "") const override
   {
-    cout << prefix << "Box: " << label << endl;
+    string out, indent = prefix;
+    appendContents(out, indent);
+    cout << out << flush;
+  }
+  void appendContents(string &out, string &prefix) const override
+  {
+    out.append(prefix).append("Box: ").append(label).append("\n");
+    prefix += "  ";
     for (const auto &c : contents)
     {
-      c->printContents(prefix + "  ");
+      c->appendContents(out, prefix);
     }
+    prefix.resize(prefix.size() - 2);
+  }
+  void printContentsParallel(WorkStealingExecutor &executor, size_t threshold = defaultThreshold,
+                             const string &prefix = "") const
+  {
+    string out, indent = prefix;
+    appendContentsParallel(out, indent, executor, max<size_t>(threshold, 1));
+    cout << out << flush;
   }
   double getPrice() const override
   {
@@ -86,8 +392,200 @@ public:
     }
     return total;
   }
+  // Partial sums are added in child order, so repeated calls give the same total
+  double getPriceParallel(WorkStealingExecutor &executor, size_t threshold = defaultThreshold) const
+  {
+    threshold = max<size_t>(threshold, 1);
+    if (nodes < threshold)
+      return getPrice();
+    vector<Chunk> chunks = split(threshold);
+    vector<double> partial(chunks.size());
+    TaskGroup group(executor);
+    for (size_t k = 0; k < chunks.size(); ++k)
+    {
+      group.run([this, &chunks, &partial, &executor, threshold, k]()
+                {
+                  const Chunk &chunk = chunks[k];
+                  if (chunk.box)
+                  {
+                    partial[k] = chunk.box->getPriceParallel(executor, threshold);
+                    return;
+                  }
+                  double sum = 0;
+                  for (size_t i = chunk.begin; i < chunk.end; ++i)
+                    sum += contents[i]->getPrice();
+                  partial[k] = sum;
+                });
+    }
+    group.wait();
+    double total = 0;
+    for (double sum : partial)
+    {
+      total += sum;
+    }
+    return total;
+  }
+  void flattenInto(PackageTree &tree) const override;
 };
 
+// Flattened tree: nodes in preorder, each box followed by its descendants in [index + 1, end)
+class PackageTree
+{
+public:
+  static constexpr uint32_t npos = UINT32_MAX;
+
+private:
+  struct Node
+  {
+    double total; // item price, or box subtotal
+    uint32_t parent;
+    uint32_t end; // one past the last descendant
+    bool box;
+  };
+
+  vector<Node> nodes;
+  vector<string> labels;
+  vector<uint32_t> openBoxes; // used while flattening
+
+  friend class Item;
+  friend class Box;
+
+  void appendItem(const string &name, double price)
+  {
+    uint32_t parent = openBoxes.empty() ? npos : openBoxes.back();
+    uint32_t index = uint32_t(nodes.size());
+    nodes.push_back({price, parent, index + 1, false});
+    labels.push_back(name);
+  }
+  void openBox(const string &label)
+  {
+    appendItem(label, 0);
+    nodes.back().box = true;
+    openBoxes.push_back(nodes.back().end - 1);
+  }
+  void closeBox()
+  {
+    uint32_t index = openBoxes.back();
+    openBoxes.pop_back();
+    Node &box = nodes[index];
+    box.end = uint32_t(nodes.size());
+    // Children are already final, so sum them in the same order as Box::getPrice
+    double total = 0;
+    for (uint32_t child = index + 1; child < box.end; child = nodes[child].end)
+    {
+      total += nodes[child].total;
+    }
+    box.total = total;
+  }
+
+  // Adds delta to every box from node up to the root; grows the ends that stopped at `insertedAt`
+  void updatePath(uint32_t node, double delta, uint32_t insertedAt = npos, uint32_t count = 0)
+  {
+    for (; node != npos; node = nodes[node].parent)
+    {
+      if (nodes[node].end == insertedAt)
+        nodes[node].end += count;
+      nodes[node].total += delta;
+    }
+  }
+
+  void printNode(size_t node, const string &prefix) const
+  {
+    if (!nodes[node].box)
+    {
+      cout << prefix << "Item: " << labels[node] << " ($" << nodes[node].total << ")" << endl;
+      return;
+    }
+    cout << prefix << "Box: " << labels[node] << endl;
+    for (size_t child = node + 1; child < nodes[node].end; child = nodes[child].end)
+    {
+      printNode(child, prefix + "  ");
+    }
+  }
+
+public:
+  PackageTree() = default;
+  explicit PackageTree(const PackageComponent &root)
+  {
+    root.flattenInto(*this);
+  }
+
+  size_t size() const { return nodes.size(); }
+  bool isBox(size_t node) const { return nodes[node].box; }
+  const string &getLabel(size_t node) const { return labels[node]; }
+  size_t getParent(size_t node) const { return nodes[node].parent; }
+  // Descendants of node are [node + 1, subtreeEnd(node))
+  size_t subtreeEnd(size_t node) const { return nodes[node].end; }
+
+  double getPrice() const
+  {
+    return nodes.empty() ? 0 : nodes[0].total;
+  }
+  double getPrice(size_t node) const
+  {
+    return nodes[node].total;
+  }
+
+  void setPrice(size_t item, double price)
+  {
+    if (nodes[item].box)
+      throw invalid_argument("PackageTree::setPrice: node is a box");
+    double delta = price - nodes[item].total;
+    nodes[item].total = price;
+    updatePath(nodes[item].parent, delta);
+  }
+
+  // Appends component as the last child of box; returns the new node's index.
+  // Indices at or after the returned one move up by the number of nodes added.
+  size_t add(size_t box, const PackageComponent &component)
+  {
+    if (!nodes[box].box)
+      throw invalid_argument("PackageTree::add: node is not a box");
+    PackageTree subtree(component);
+    uint32_t at = nodes[box].end;
+    uint32_t count = uint32_t(subtree.size());
+    for (auto &node : nodes)
+    {
+      if (node.parent != npos && node.parent >= at)
+        node.parent += count;
+      if (node.end > at)
+        node.end += count;
+    }
+    for (auto &node : subtree.nodes)
+    {
+      node.parent = node.parent == npos ? uint32_t(box) : node.parent + at;
+      node.end += at;
+    }
+    nodes.insert(nodes.begin() + at, subtree.nodes.begin(), subtree.nodes.end());
+    labels.insert(labels.begin() + at, make_move_iterator(subtree.labels.begin()),
+                  make_move_iterator(subtree.labels.end()));
+    updatePath(uint32_t(box), subtree.getPrice(), at, count);
+    return at;
+  }
+
+  void printContents(const string &prefix = "") const
+  {
+    if (!nodes.empty())
+      printNode(0, prefix);
+  }
+};
+
+void Item::flattenInto(PackageTree &tree) const
+{
+  tree.appendItem(name, price);
+}
+
+void Box::flattenInto(PackageTree &tree) const
+{
+  tree.openBox(label);
+  for (const auto &c : contents)
+  {
+    c->flattenInto(tree);
+  }
+  tree.closeBox();
+}
+
+#ifndef DESIGN_PATTERNS_NO_MAIN
 int main()
 {
   // Create items
@@ -114,5 +612,21 @@ int main()
   package->printContents();
   cout << "\nTotal Price: $" << package->getPrice() << endl;
 
+  // Flattened copy: cached subtotals, updates touch only the path to the root
+  PackageTree tree(*package);
+  size_t added = tree.add(0, Item("Headphones", 49.99));
+  cout << "\nFlattened Package (with Headphones):" << endl;
+  tree.printContents();
+  cout << "Total Price: $" << tree.getPrice() << endl;
+  tree.setPrice(added, 39.99);
+  cout << "After discount: $" << tree.getPrice() << endl;
+
+  // Parallel aggregation; a threshold of 2 forces the tiny demo package to split
+  WorkStealingExecutor executor(2);
+  cout << "\nParallel Contents:" << endl;
+  package->printContentsParallel(executor, 2);
+  cout << "Parallel Total Price: $" << package->getPriceParallel(executor, 2) << endl;
+
   return 0;
 }
+#endif
@@ -20,19 +20,58 @@ Example: Coffee Shop
 --------------------
 Suppose you are building a coffee shop ordering system. You have a base coffee, and you want to allow customers to add milk, sugar, or other condiments. Each addition should be a decorator that adds its own cost and description.
 
+Flattened Chains:
+- A decorated coffee recomputes cost() and getDescription() through every layer on every call, and each layer
+  builds a new string. flatten(coffee) collapses a chain once into a CoffeeRecipe: the base plus a small inline
+  array of condiment ids, with cost and description cached as condiments are added.
+- Each decorator adds its condiment id in flattenInto(); a component without its own flattenInto() becomes the
+  recipe's base as a whole, so unknown decorators still flatten correctly.
+- Decorated<SimpleCoffee, Milk, Sugar> fixes the condiments at compile time; its cost is a constant expression.
+- Condiment names and prices live in one table used by the decorators, the recipe and the template alike.
+
 */
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
 using namespace std;
 
+// Condiment ids and their catalogue entries
+enum class Condiment : uint8_t
+{
+  Milk,
+  Sugar
+};
+
+struct CondimentInfo
+{
+  string_view name;
+  double price;
+};
+
+constexpr array<CondimentInfo, 2> condimentCatalogue{{{"Milk", 0.5}, {"Sugar", 0.2}}};
+
+constexpr const CondimentInfo &condimentInfo(Condiment id)
+{
+  return condimentCatalogue[size_t(id)];
+}
+
+class CoffeeRecipe;
+
 // Component
 class Coffee
 {
 public:
   virtual string getDescription() const = 0;
   virtual double cost() const = 0;
+  // Appends this coffee to recipe; by default the whole coffee becomes the recipe's base
+  virtual void flattenInto(CoffeeRecipe &recipe) const;
   virtual ~Coffee() {}
 };
 
@@ -40,13 +79,15 @@ public:
 class SimpleCoffee : public Coffee
 {
 public:
+  static constexpr string_view name = "Simple Coffee";
+  static constexpr double price = 2.0;
   string getDescription() const override
   {
-    return "Simple Coffee";
+    return string(name);
   }
   double cost() const override
   {
-    return 2.0;
+    return price;
   }
 };
 
@@ -64,6 +105,7 @@ public:
 class Milk : public CoffeeDecorator
 {
 public:
+  static constexpr Condiment id = Condiment::Milk;
   Milk(shared_ptr<Coffee> c) : CoffeeDecorator(c) {}
   string getDescription() const override
   {
@@ -71,14 +113,16 @@ public:
   }
   double cost() const override
   {
-    return coffee->cost() + 0.5;
+    return coffee->cost() + condimentInfo(id).price;
   }
+  void flattenInto(CoffeeRecipe &recipe) const override;
 };
 
 // ConcreteDecorator: Sugar
 class Sugar : public CoffeeDecorator
 {
 public:
+  static constexpr Condiment id = Condiment::Sugar;
   Sugar(shared_ptr<Coffee> c) : CoffeeDecorator(c) {}
   string getDescription() const override
   {
@@ -86,10 +130,130 @@ public:
   }
   double cost() const override
   {
-    return coffee->cost() + 0.2;
+    return coffee->cost() + condimentInfo(id).price;
+  }
+  void flattenInto(CoffeeRecipe &recipe) const override;
+};
+
+// Flat form of a decorated coffee: base plus condiment ids, with cost and description kept up to date
+class CoffeeRecipe : public Coffee
+{
+  static constexpr size_t inlineCapacity = 14;
+
+  string baseDescription;
+  double baseCost = 0;
+  string cachedDescription;
+  double cachedCost = 0;
+  uint32_t count = 0;
+  array<Condiment, inlineCapacity> inlineIds{};
+  vector<Condiment> spilled; // holds every id once there are more than inlineCapacity
+
+public:
+  CoffeeRecipe() = default;
+  CoffeeRecipe(string_view description, double price) { setBase(description, price); }
+
+  // Replaces the base and drops all condiments
+  void setBase(string_view description, double price)
+  {
+    baseDescription = description;
+    baseCost = price;
+    cachedDescription = baseDescription;
+    cachedCost = baseCost;
+    count = 0;
+    spilled.clear();
+  }
+
+  void add(Condiment id)
+  {
+    if (count < inlineCapacity)
+      inlineIds[count] = id;
+    else
+    {
+      if (count == inlineCapacity)
+        spilled.assign(inlineIds.begin(), inlineIds.end());
+      spilled.push_back(id);
+    }
+    ++count;
+    const CondimentInfo &info = condimentInfo(id);
+    cachedCost += info.price;
+    cachedDescription += ", ";
+    cachedDescription += info.name;
+  }
+
+  size_t condimentCount() const { return count; }
+  Condiment condiment(size_t i) const { return count <= inlineCapacity ? inlineIds[i] : spilled[i]; }
+  const string &base() const { return baseDescription; }
+  const string &description() const { return cachedDescription; }
+
+  string getDescription() const override { return cachedDescription; }
+  double cost() const override { return cachedCost; }
+  void flattenInto(CoffeeRecipe &recipe) const override
+  {
+    recipe.setBase(baseDescription, baseCost);
+    for (size_t i = 0; i < count; ++i)
+    {
+      recipe.add(condiment(i));
+    }
+  }
+};
+
+void Coffee::flattenInto(CoffeeRecipe &recipe) const
+{
+  recipe.setBase(getDescription(), cost());
+}
+
+void Milk::flattenInto(CoffeeRecipe &recipe) const
+{
+  coffee->flattenInto(recipe);
+  recipe.add(id);
+}
+
+void Sugar::flattenInto(CoffeeRecipe &recipe) const
+{
+  coffee->flattenInto(recipe);
+  recipe.add(id);
+}
+
+// Collapses a decorator chain into a recipe with cached cost and description
+CoffeeRecipe flatten(const Coffee &coffee)
+{
+  CoffeeRecipe recipe;
+  coffee.flattenInto(recipe);
+  return recipe;
+}
+
+// Decorator chain fixed at compile time, applied left to right: Decorated<SimpleCoffee, Milk, Sugar>
+template <typename Base, typename... Condiments>
+class Decorated final : public Coffee
+{
+public:
+  // Same left-to-right summation as the runtime chain, so both give identical prices
+  static constexpr double price = (Base::price + ... + condimentInfo(Condiments::id).price);
+  static constexpr size_t depth = sizeof...(Condiments);
+
+  static const string &description()
+  {
+    static const string text = []()
+    {
+      string d(Base::name);
+      ((d += ", ", d += condimentInfo(Condiments::id).name), ...);
+      return d;
+    }();
+    return text;
+  }
+
+  string getDescription() const override { return description(); }
+  double cost() const override { return price; }
+  void flattenInto(CoffeeRecipe &recipe) const override
+  {
+    recipe.setBase(Base::name, Base::price);
+    (recipe.add(Condiments::id), ...);
   }
 };
 
+static_assert(Decorated<SimpleCoffee, Milk, Sugar>::price == 2.0 + 0.5 + 0.2);
+
+#ifndef DESIGN_PATTERNS_NO_MAIN
 int main()
 {
   shared_ptr<Coffee> coffee = make_shared<SimpleCoffee>();
@@ -102,5 +266,14 @@ int main()
   cout << coffee->getDescription() << " : $" << coffee->cost() << endl;
 
   // You can add more decorators as needed
+  coffee = make_shared<Milk>(coffee);
+  CoffeeRecipe recipe = flatten(*coffee);
+  cout << "\nFlattened (" << recipe.condimentCount() << " condiments): " << recipe.description() << " : $"
+       << recipe.cost() << endl;
+
+  Decorated<SimpleCoffee, Milk, Sugar> fixed;
+  constexpr double fixedPrice = Decorated<SimpleCoffee, Milk, Sugar>::price;
+  cout << "Compile-time: " << fixed.getDescription() << " : $" << fixedPrice << endl;
   return 0;
-}
\ No newline at end of file
+}
+#endif
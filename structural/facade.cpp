@@ -18,48 +18,241 @@ Example: Ecommerce Application
 ------------------------------
 Suppose you are building an ecommerce application. Placing an order involves multiple subsystems: inventory, payment, and shipping. The Facade pattern allows you to provide a simple `placeOrder` method that hides all the complexity from the client.
 
+Batched Orders:
+- Every subsystem call is a round trip in a real deployment; subsystems take a simulated round-trip latency and
+  count the trips they serve. Each subsystem also has a batch call that serves many orders in one trip.
+- placeOrders(orders) reserves stock per distinct item in one inventory request, sends the payments of all
+  reserved orders in one request, and ships the paid orders in one manifest holding one parcel per address.
+- Each order gets its own OrderStatus. Orders whose payment fails have their reserved stock released; within a
+  batch, released stock is not offered again to later orders of the same batch.
+- startPipeline() runs the reservation, payment and shipping stages on their own threads; submit(orders) returns
+  a future, and while one batch is being paid for the next can already be reserved.
+
 */
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <span>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <future>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <cstdint>
 using namespace std;
 
+// Stands in for the network cost of one subsystem request
+class RoundTrip
+{
+  chrono::microseconds latency;
+  atomic<uint64_t> trips{0};
+
+public:
+  explicit RoundTrip(chrono::microseconds l) : latency(l) {}
+  void pay()
+  {
+    ++trips;
+    if (latency.count() > 0)
+      this_thread::sleep_for(latency);
+  }
+  uint64_t count() const { return trips.load(); }
+};
+
+struct StockRequest
+{
+  string item;
+  int quantity;
+};
+
 // Subsystem: Inventory
 class Inventory
 {
+  mutex lock;
+  unordered_map<string, int> stock; // items not listed are unlimited
+  RoundTrip trip;
+
 public:
+  explicit Inventory(chrono::microseconds roundTrip = {}) : trip(roundTrip) {}
+  void setStock(const string &item, int count)
+  {
+    lock_guard<mutex> guard(lock);
+    stock[item] = count;
+  }
   bool checkStock(const string &item)
   {
     cout << "[Inventory] Checking stock for '" << item << "'..." << endl;
-    return true; // Assume always in stock for this example
+    trip.pay();
+    lock_guard<mutex> guard(lock);
+    auto it = stock.find(item);
+    return it == stock.end() || it->second > 0;
   }
   void reserveItem(const string &item)
   {
     cout << "[Inventory] Reserving '" << item << "'..." << endl;
+    trip.pay();
+    lock_guard<mutex> guard(lock);
+    auto it = stock.find(item);
+    if (it != stock.end())
+      --it->second;
+  }
+  void releaseItem(const string &item)
+  {
+    cout << "[Inventory] Releasing '" << item << "'..." << endl;
+    trip.pay();
+    lock_guard<mutex> guard(lock);
+    auto it = stock.find(item);
+    if (it != stock.end())
+      ++it->second;
   }
+  // One request: reserves up to quantity of each item, returns how many were granted per request
+  vector<int> reserveItems(span<const StockRequest> requests)
+  {
+    cout << "[Inventory] Reserving batch (items: " << requests.size() << ")..." << endl;
+    trip.pay();
+    vector<int> granted(requests.size());
+    lock_guard<mutex> guard(lock);
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+      auto it = stock.find(requests[i].item);
+      granted[i] = it == stock.end() ? requests[i].quantity : min(requests[i].quantity, max(it->second, 0));
+      if (it != stock.end())
+        it->second -= granted[i];
+    }
+    return granted;
+  }
+  void releaseItems(span<const StockRequest> requests)
+  {
+    cout << "[Inventory] Releasing batch (items: " << requests.size() << ")..." << endl;
+    trip.pay();
+    lock_guard<mutex> guard(lock);
+    for (const auto &r : requests)
+    {
+      auto it = stock.find(r.item);
+      if (it != stock.end())
+        it->second += r.quantity;
+    }
+  }
+  int available(const string &item)
+  {
+    lock_guard<mutex> guard(lock);
+    auto it = stock.find(item);
+    return it == stock.end() ? -1 : it->second;
+  }
+  uint64_t roundTrips() const { return trip.count(); }
+};
+
+struct PaymentRequest
+{
+  string customer;
+  double amount;
 };
 
 // Subsystem: Payment
 class Payment
 {
+  mutex lock;
+  unordered_set<string> declined;
+  RoundTrip trip;
+
+  bool charge(const string &customer)
+  {
+    lock_guard<mutex> guard(lock);
+    return !declined.count(customer);
+  }
+
 public:
+  explicit Payment(chrono::microseconds roundTrip = {}) : trip(roundTrip) {}
+  void declineCustomer(const string &customer)
+  {
+    lock_guard<mutex> guard(lock);
+    declined.insert(customer);
+  }
   bool processPayment(const string &customer, double amount)
   {
     cout << "[Payment] Processing payment of $" << amount << " for '" << customer << "'..." << endl;
-    return true; // Assume payment always succeeds
+    trip.pay();
+    return charge(customer);
+  }
+  // One request for many payments; result[i] is true if requests[i] was charged
+  vector<bool> processPayments(span<const PaymentRequest> requests)
+  {
+    cout << "[Payment] Processing batch (payments: " << requests.size() << ")..." << endl;
+    trip.pay();
+    vector<bool> charged(requests.size());
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+      charged[i] = charge(requests[i].customer);
+    }
+    return charged;
   }
+  uint64_t roundTrips() const { return trip.count(); }
+};
+
+struct Parcel
+{
+  string address;
+  vector<string> items;
 };
 
 // Subsystem: Shipping
 class Shipping
 {
+  RoundTrip trip;
+
 public:
+  explicit Shipping(chrono::microseconds roundTrip = {}) : trip(roundTrip) {}
   void createShipment(const string &item, const string &address)
   {
     cout << "[Shipping] Shipping '" << item << "' to '" << address << "'..." << endl;
+    trip.pay();
+  }
+  // One manifest, one parcel per address
+  void createShipments(span<const Parcel> parcels)
+  {
+    cout << "[Shipping] Sending manifest (parcels: " << parcels.size() << ")..." << endl;
+    trip.pay();
   }
+  uint64_t roundTrips() const { return trip.count(); }
+};
+
+struct Order
+{
+  string customer;
+  string item;
+  double amount;
+  string address;
 };
 
+enum class OrderStatus
+{
+  Placed,
+  OutOfStock,
+  PaymentFailed
+};
+
+string statusToString(OrderStatus status)
+{
+  switch (status)
+  {
+  case OrderStatus::Placed:
+    return "Placed";
+  case OrderStatus::OutOfStock:
+    return "Out of stock";
+  case OrderStatus::PaymentFailed:
+    return "Payment failed";
+  default:
+    return "Unknown";
+  }
+}
+
 // Facade
 class OrderFacade
 {
@@ -67,31 +260,297 @@ class OrderFacade
   Payment payment;
   Shipping shipping;
 
+  // Orders moving through the stages; status is final once a stage rejects an order
+  struct OrderBatch
+  {
+    vector<Order> orders;
+    vector<OrderStatus> status;
+    vector<bool> live;
+    promise<vector<OrderStatus>> done;
+  };
+
+  // Blocking hand-off between two pipeline stages
+  class StageQueue
+  {
+    mutex lock;
+    condition_variable ready;
+    deque<unique_ptr<OrderBatch>> batches;
+    bool closed = false;
+
+  public:
+    void push(unique_ptr<OrderBatch> batch)
+    {
+      {
+        lock_guard<mutex> guard(lock);
+        batches.push_back(std::move(batch));
+      }
+      ready.notify_one();
+    }
+    // nullptr once closed and drained
+    unique_ptr<OrderBatch> pop()
+    {
+      unique_lock<mutex> guard(lock);
+      ready.wait(guard, [&]()
+                 { return closed || !batches.empty(); });
+      if (batches.empty())
+        return nullptr;
+      auto batch = std::move(batches.front());
+      batches.pop_front();
+      return batch;
+    }
+    void close()
+    {
+      {
+        lock_guard<mutex> guard(lock);
+        closed = true;
+      }
+      ready.notify_all();
+    }
+    void reopen()
+    {
+      lock_guard<mutex> guard(lock);
+      closed = false;
+    }
+  };
+
+  StageQueue toReserve, toPay, toShip;
+  vector<thread> stages;
+
+  // One inventory request for all distinct items; earlier orders of an item are served first
+  void reserveStage(OrderBatch &batch)
+  {
+    map<string, vector<size_t>> byItem;
+    for (size_t i = 0; i < batch.orders.size(); ++i)
+    {
+      byItem[batch.orders[i].item].push_back(i);
+    }
+    vector<StockRequest> requests;
+    requests.reserve(byItem.size());
+    for (const auto &[item, orders] : byItem)
+    {
+      requests.push_back({item, int(orders.size())});
+    }
+    vector<int> granted = requests.empty() ? vector<int>() : inventory.reserveItems(requests);
+    size_t r = 0;
+    for (const auto &[item, orders] : byItem)
+    {
+      for (size_t k = size_t(granted[r]); k < orders.size(); ++k)
+      {
+        batch.status[orders[k]] = OrderStatus::OutOfStock;
+        batch.live[orders[k]] = false;
+      }
+      ++r;
+    }
+  }
+
+  // One payment request for every reserved order; declined orders give their stock back
+  void paymentStage(OrderBatch &batch)
+  {
+    vector<size_t> index;
+    vector<PaymentRequest> requests;
+    for (size_t i = 0; i < batch.orders.size(); ++i)
+    {
+      if (batch.live[i])
+      {
+        index.push_back(i);
+        requests.push_back({batch.orders[i].customer, batch.orders[i].amount});
+      }
+    }
+    if (requests.empty())
+      return;
+    vector<bool> charged = payment.processPayments(requests);
+    map<string, int> refunds;
+    for (size_t k = 0; k < index.size(); ++k)
+    {
+      if (!charged[k])
+      {
+        batch.status[index[k]] = OrderStatus::PaymentFailed;
+        batch.live[index[k]] = false;
+        ++refunds[batch.orders[index[k]].item];
+      }
+    }
+    if (!refunds.empty())
+    {
+      vector<StockRequest> release;
+      for (const auto &[item, quantity] : refunds)
+      {
+        release.push_back({item, quantity});
+      }
+      inventory.releaseItems(release);
+    }
+  }
+
+  // One manifest; orders to the same address share a parcel
+  void shippingStage(OrderBatch &batch)
+  {
+    map<string, size_t> parcelOf;
+    vector<Parcel> parcels;
+    for (size_t i = 0; i < batch.orders.size(); ++i)
+    {
+      if (!batch.live[i])
+        continue;
+      auto [it, added] = parcelOf.try_emplace(batch.orders[i].address, parcels.size());
+      if (added)
+        parcels.push_back({batch.orders[i].address, {}});
+      parcels[it->second].items.push_back(batch.orders[i].item);
+    }
+    if (!parcels.empty())
+      shipping.createShipments(parcels);
+  }
+
+  static unique_ptr<OrderBatch> makeBatch(vector<Order> orders)
+  {
+    auto batch = make_unique<OrderBatch>();
+    batch->status.assign(orders.size(), OrderStatus::Placed);
+    batch->live.assign(orders.size(), true);
+    batch->orders = std::move(orders);
+    return batch;
+  }
+
+  // Runs step on every batch from in, then hands it to out (or completes it)
+  template <typename Step>
+  void stageLoop(StageQueue &in, StageQueue *out, Step step)
+  {
+    while (auto batch = in.pop())
+    {
+      try
+      {
+        step(*batch);
+      }
+      catch (...)
+      {
+        batch->done.set_exception(current_exception());
+        continue;
+      }
+      if (out)
+        out->push(std::move(batch));
+      else
+        batch->done.set_value(std::move(batch->status));
+    }
+    if (out)
+      out->close();
+  }
+
 public:
-  void placeOrder(const string &customer, const string &item, double amount, const string &address)
+  explicit OrderFacade(chrono::microseconds roundTrip = {})
+      : inventory(roundTrip), payment(roundTrip), shipping(roundTrip) {}
+  ~OrderFacade() { stopPipeline(); }
+
+  OrderStatus placeOrder(const string &customer, const string &item, double amount, const string &address)
   {
     cout << "\n[OrderFacade] Placing order for '" << customer << "'..." << endl;
     if (!inventory.checkStock(item))
     {
       cout << "[OrderFacade] Item out of stock!" << endl;
-      return;
+      return OrderStatus::OutOfStock;
     }
     inventory.reserveItem(item);
     if (!payment.processPayment(customer, amount))
     {
       cout << "[OrderFacade] Payment failed!" << endl;
-      return;
+      inventory.releaseItem(item);
+      return OrderStatus::PaymentFailed;
     }
     shipping.createShipment(item, address);
     cout << "[OrderFacade] Order placed successfully!" << endl;
+    return OrderStatus::Placed;
+  }
+
+  OrderStatus placeOrder(const Order &order)
+  {
+    return placeOrder(order.customer, order.item, order.amount, order.address);
+  }
+
+  // Places a batch with one request per subsystem stage; result[i] belongs to orders[i]
+  vector<OrderStatus> placeOrders(span<const Order> orders)
+  {
+    cout << "\n[OrderFacade] Placing " << orders.size() << " orders as one batch..." << endl;
+    auto batch = makeBatch(vector<Order>(orders.begin(), orders.end()));
+    reserveStage(*batch);
+    paymentStage(*batch);
+    shippingStage(*batch);
+    return std::move(batch->status);
+  }
+
+  // Starts one thread per stage; submit() is available until stopPipeline()
+  void startPipeline()
+  {
+    if (!stages.empty())
+      return;
+    toReserve.reopen();
+    toPay.reopen();
+    toShip.reopen();
+    stages.emplace_back([this]()
+                        { stageLoop(toReserve, &toPay, [this](OrderBatch &b)
+                                    { reserveStage(b); }); });
+    stages.emplace_back([this]()
+                        { stageLoop(toPay, &toShip, [this](OrderBatch &b)
+                                    { paymentStage(b); }); });
+    stages.emplace_back([this]()
+                        { stageLoop(toShip, nullptr, [this](OrderBatch &b)
+                                    { shippingStage(b); }); });
+  }
+
+  // Finishes every submitted batch, then joins the stage threads
+  void stopPipeline()
+  {
+    if (stages.empty())
+      return;
+    toReserve.close();
+    for (auto &t : stages)
+    {
+      t.join();
+    }
+    stages.clear();
   }
+
+  // Queues a batch on the running pipeline
+  future<vector<OrderStatus>> submit(vector<Order> orders)
+  {
+    if (stages.empty())
+      throw logic_error("OrderFacade::submit: pipeline is not running");
+    auto batch = makeBatch(std::move(orders));
+    auto result = batch->done.get_future();
+    toReserve.push(std::move(batch));
+    return result;
+  }
+
+  Inventory &getInventory() { return inventory; }
+  Payment &getPayment() { return payment; }
+  uint64_t roundTrips() const { return inventory.roundTrips() + payment.roundTrips() + shipping.roundTrips(); }
 };
 
+#ifndef DESIGN_PATTERNS_NO_MAIN
 // Client code
 int main()
 {
   OrderFacade facade;
   facade.placeOrder("Alice", "Laptop", 999.99, "123 Main St");
   facade.placeOrder("Bob", "Phone", 499.99, "456 Elm St");
+
+  // Batch: one phone left, and Dave's card is declined
+  facade.getInventory().setStock("Phone", 1);
+  facade.getPayment().declineCustomer("Dave");
+  vector<Order> orders = {
+      {"Carol", "Phone", 499.99, "789 Oak St"},
+      {"Dave", "Laptop", 999.99, "12 Pine St"},
+      {"Erin", "Phone", 499.99, "34 Birch St"},
+      {"Frank", "Headphones", 79.99, "789 Oak St"},
+  };
+  vector<OrderStatus> results = facade.placeOrders(orders);
+  for (size_t i = 0; i < orders.size(); ++i)
+  {
+    cout << "  " << orders[i].customer << " (" << orders[i].item << "): " << statusToString(results[i]) << endl;
+  }
+
+  // Pipelined: stages run on their own threads
+  facade.getInventory().setStock("Phone", 1);
+  facade.startPipeline();
+  auto first = facade.submit({{"Grace", "Phone", 499.99, "56 Cedar St"}});
+  auto second = facade.submit({{"Heidi", "Phone", 499.99, "78 Maple St"}});
+  OrderStatus grace = first.get()[0], heidi = second.get()[0];
+  facade.stopPipeline();
+  cout << "\nPipelined: Grace " << statusToString(grace) << ", Heidi " << statusToString(heidi) << endl;
   return 0;
-}
\ No newline at end of file
+}
+#endif
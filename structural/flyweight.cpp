@@ -19,83 +19,525 @@ Example: Game (Trees in a Forest)
 ---------------------------------
 Suppose you are building a game with a large forest. Each tree has a type (species, texture, color) that can be shared, and a position (x, y) that is unique. The Flyweight pattern allows you to share tree types and only store unique positions for each tree.
 
+CompactForest takes the idea further for very large forests: tree types live in a dense table indexed by a 16-bit id, and the extrinsic state is stored as struct-of-arrays (xs, ys, typeIds), so each tree costs 10 bytes and planting needs no reference counting.
+Factories key types on (name, color, texture) views and intern the strings, so a lookup that hits allocates nothing.
+A TreeType views its factory's interned strings, so factories hand out `const TreeType *` valid for the factory's lifetime.
+ConcurrentTreeFactory lets loader threads share types: lookups that hit are lock-free and return stable TreeType pointers.
+Forest also keeps a uniform grid over tree positions, updated on every plantTree, so draw(viewport) only touches the visible cells.
+drawBatched(Sink&) groups instances by type and hands each TreeType one contiguous span of positions, so the output target is pluggable.
+bench/flyweight.cpp measures factory lookups (single- and multi-threaded), plantTree, memory per tree and every draw path.
+
 */
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <memory>
+#include <span>
+#include <cstdint>
+#include <stdexcept>
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <thread>
 using namespace std;
 
-// Flyweight: Shared tree type
+// Interned strings: each distinct name/color/texture is stored once and handed out as a stable view
+class StringInterner
+{
+  struct Hash
+  {
+    using is_transparent = void;
+    size_t operator()(string_view s) const { return hash<string_view>{}(s); }
+  };
+  unordered_set<string, Hash, equal_to<>> strings;
+
+public:
+  string_view intern(string_view s)
+  {
+    auto it = strings.find(s);
+    if (it == strings.end())
+    {
+      it = strings.emplace(s).first;
+    }
+    return *it;
+  }
+  size_t size() const { return strings.size(); }
+};
+
+class TreeType;
+
+// Extrinsic state of one tree instance
+struct Position
+{
+  int x, y;
+};
+
+// Sink: Pluggable draw target that receives all instances of one tree type at once, like instanced rendering
+class Sink
+{
+public:
+  virtual void drawInstances(const TreeType &type, span<const Position> positions) = 0;
+  virtual ~Sink() {}
+};
+
+// Flyweight: Shared tree type (views point into the owning factory's StringInterner)
 class TreeType
 {
-  string name;
-  string color;
-  string texture;
+  string_view name;
+  string_view color;
+  string_view texture;
 
 public:
-  TreeType(const string &n, const string &c, const string &t)
+  TreeType(string_view n, string_view c, string_view t)
       : name(n), color(c), texture(t) {}
-  void draw(int x, int y) const
+  string_view getName() const { return name; }
+  string_view getColor() const { return color; }
+  string_view getTexture() const { return texture; }
+  void draw(int x, int y, ostream &out = cout) const
   {
-    cout << "Drawing tree '" << name << "' at (" << x << ", " << y << ") with color " << color << " and texture " << texture << endl;
+    out << "Drawing tree '" << name << "' at (" << x << ", " << y << ") with color " << color << " and texture " << texture << endl;
+  }
+  void drawInstances(span<const Position> positions, Sink &sink) const
+  {
+    sink.drawInstances(*this, positions);
+  }
+};
+
+// Concrete Sink: Writes one line per tree type to a stream
+class ConsoleSink : public Sink
+{
+  ostream &out;
+
+public:
+  ConsoleSink(ostream &o = cout) : out(o) {}
+  void drawInstances(const TreeType &type, span<const Position> positions) override
+  {
+    out << "Drawing " << positions.size() << " x tree '" << type.getName() << "' with color " << type.getColor()
+        << " and texture " << type.getTexture() << " at";
+    for (const auto &p : positions)
+    {
+      out << " (" << p.x << ", " << p.y << ")";
+    }
+    out << '\n';
+  }
+};
+
+// Flyweight key: hashed and compared field by field, so lookups never build a combined string
+struct TreeKey
+{
+  string_view name, color, texture;
+
+  bool operator==(const TreeKey &) const = default;
+};
+
+struct TreeKeyHash
+{
+  size_t operator()(const TreeKey &k) const
+  {
+    hash<string_view> h;
+    size_t seed = h(k.name);
+    seed ^= h(k.color) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    seed ^= h(k.texture) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    return seed;
   }
 };
 
 // Flyweight Factory: Manages tree types
+// A hit costs one hash and no allocation; stored keys view interned strings, so they outlive the caller's.
+// Returned types view those strings too: the pointers stay valid for as long as the factory lives.
 class TreeFactory
 {
-  unordered_map<string, shared_ptr<TreeType>> types;
+  StringInterner strings;
+  unordered_map<TreeKey, unique_ptr<TreeType>, TreeKeyHash> types;
+
+public:
+  const TreeType *getTreeType(string_view name, string_view color, string_view texture)
+  {
+    auto it = types.find(TreeKey{name, color, texture});
+    if (it != types.end())
+    {
+      return it->second.get();
+    }
+    TreeKey key{strings.intern(name), strings.intern(color), strings.intern(texture)};
+    auto type = make_unique<TreeType>(key.name, key.color, key.texture);
+    const TreeType *result = type.get();
+    types.try_emplace(key, move(type));
+    return result;
+  }
+  size_t size() const { return types.size(); }
+};
+
+// Concurrent Flyweight Factory: Thread-safe variant for parallel level loading
+// Types are sharded by hash. Each shard is an open-addressing table of atomic entry pointers:
+// hits are lock-free acquire loads, misses take the shard mutex. Entries never move or die
+// before the factory, so callers hold plain TreeType pointers without refcounting.
+class ConcurrentTreeFactory
+{
+  static constexpr size_t shardCount = 64;
+
+  struct Entry
+  {
+    size_t hash;
+    TreeKey key;
+    TreeType type;
+    Entry(size_t h, const TreeKey &k) : hash(h), key(k), type(k.name, k.color, k.texture) {}
+  };
+
+  struct Table
+  {
+    size_t mask;
+    unique_ptr<atomic<const Entry *>[]> slots;
+    explicit Table(size_t capacity) : mask(capacity - 1), slots(new atomic<const Entry *>[capacity])
+    {
+      for (size_t i = 0; i < capacity; ++i)
+      {
+        slots[i].store(nullptr, memory_order_relaxed);
+      }
+    }
+  };
+
+  struct alignas(64) Shard
+  {
+    atomic<Table *> table{nullptr};
+    mutex writeLock;
+    size_t count = 0;
+    StringInterner strings;
+    deque<Entry> entries;
+    vector<unique_ptr<Table>> tables; // Retired tables stay alive for in-flight readers
+  };
+
+  Shard shards[shardCount];
+
+  static const Entry *find(const Table *table, const TreeKey &key, size_t hash)
+  {
+    for (size_t i = (hash / shardCount) & table->mask;; i = (i + 1) & table->mask)
+    {
+      const Entry *e = table->slots[i].load(memory_order_acquire);
+      if (!e || (e->hash == hash && e->key == key))
+      {
+        return e;
+      }
+    }
+  }
+  static void insert(Table *table, const Entry *entry)
+  {
+    size_t i = (entry->hash / shardCount) & table->mask;
+    while (table->slots[i].load(memory_order_relaxed))
+    {
+      i = (i + 1) & table->mask;
+    }
+    table->slots[i].store(entry, memory_order_release);
+  }
 
 public:
-  shared_ptr<TreeType> getTreeType(const string &name, const string &color, const string &texture)
+  ConcurrentTreeFactory()
+  {
+    for (auto &shard : shards)
+    {
+      shard.tables.push_back(make_unique<Table>(16));
+      shard.table.store(shard.tables.back().get(), memory_order_release);
+    }
+  }
+  ConcurrentTreeFactory(const ConcurrentTreeFactory &) = delete;
+  ConcurrentTreeFactory &operator=(const ConcurrentTreeFactory &) = delete;
+
+  const TreeType *getTreeType(string_view name, string_view color, string_view texture)
   {
-    string key = name + ":" + color + ":" + texture;
-    if (types.find(key) == types.end())
+    TreeKey key{name, color, texture};
+    size_t hash = TreeKeyHash{}(key);
+    Shard &shard = shards[hash % shardCount];
+    if (const Entry *e = find(shard.table.load(memory_order_acquire), key, hash))
     {
-      types[key] = make_shared<TreeType>(name, color, texture);
+      return &e->type;
     }
-    return types[key];
+
+    lock_guard<mutex> lock(shard.writeLock);
+    Table *table = shard.table.load(memory_order_relaxed);
+    if (const Entry *e = find(table, key, hash))
+    {
+      return &e->type;
+    }
+    if ((shard.count + 1) * 2 > table->mask + 1)
+    {
+      auto grown = make_unique<Table>((table->mask + 1) * 2);
+      for (const auto &e : shard.entries)
+      {
+        insert(grown.get(), &e);
+      }
+      table = grown.get();
+      shard.tables.push_back(move(grown));
+      shard.table.store(table, memory_order_release);
+    }
+    TreeKey owned{shard.strings.intern(name), shard.strings.intern(color), shard.strings.intern(texture)};
+    const Entry &entry = shard.entries.emplace_back(hash, owned);
+    insert(table, &entry);
+    ++shard.count;
+    return &entry.type;
   }
 };
 
 // Context: Individual tree with extrinsic state
+// The type belongs to the factory that made it, which must outlive the tree.
 class Tree
 {
   int x, y;
-  shared_ptr<TreeType> type;
+  const TreeType *type;
 
 public:
-  Tree(int x, int y, shared_ptr<TreeType> t) : x(x), y(y), type(t) {}
-  void draw() const
+  Tree(int x, int y, const TreeType *t) : x(x), y(y), type(t) {}
+  int getX() const { return x; }
+  int getY() const { return y; }
+  const TreeType *getType() const { return type; }
+  void draw(ostream &out = cout) const
   {
-    type->draw(x, y);
+    type->draw(x, y, out);
+  }
+};
+
+// Visible area of the world, half-open: [x, x + width) x [y, y + height)
+struct Rect
+{
+  int x, y, width, height;
+
+  bool contains(int px, int py) const
+  {
+    return px >= x && py >= y && int64_t(px) < int64_t(x) + width && int64_t(py) < int64_t(y) + height;
   }
 };
 
 // Forest: Holds many trees
+// Trees are also bucketed into a uniform grid as they are planted, so a viewport draw
+// only visits the cells it overlaps instead of the whole forest.
 class Forest
 {
   vector<Tree> trees;
   TreeFactory factory;
+  int cellSize;
+  unordered_map<uint64_t, vector<uint32_t>> cells;
+
+  int cellOf(int64_t v) const
+  {
+    return int(v >= 0 ? v / cellSize : (v + 1) / cellSize - 1);
+  }
+  static uint64_t cellKey(int cx, int cy)
+  {
+    return (uint64_t(uint32_t(cx)) << 32) | uint32_t(cy);
+  }
+  void drawCell(const vector<uint32_t> &ids, const Rect &viewport, ostream &out) const
+  {
+    for (uint32_t id : ids)
+    {
+      const Tree &tree = trees[id];
+      if (viewport.contains(tree.getX(), tree.getY()))
+      {
+        tree.draw(out);
+      }
+    }
+  }
 
 public:
+  explicit Forest(int cellSize = 64) : cellSize(cellSize) {}
+
   void plantTree(int x, int y, const string &name, const string &color, const string &texture)
   {
     auto type = factory.getTreeType(name, color, texture);
+    cells[cellKey(cellOf(x), cellOf(y))].push_back(uint32_t(trees.size()));
     trees.emplace_back(x, y, type);
   }
-  void draw() const
+  void draw(ostream &out = cout) const
   {
     for (const auto &tree : trees)
     {
-      tree.draw();
+      tree.draw(out);
     }
   }
+  // Draws only the trees inside the viewport, grouped by grid cell rather than in planting order
+  void draw(const Rect &viewport, ostream &out = cout) const
+  {
+    if (viewport.width <= 0 || viewport.height <= 0)
+    {
+      return;
+    }
+    int cx0 = cellOf(viewport.x), cx1 = cellOf(int64_t(viewport.x) + viewport.width - 1);
+    int cy0 = cellOf(viewport.y), cy1 = cellOf(int64_t(viewport.y) + viewport.height - 1);
+    if (uint64_t(cx1 - cx0 + 1) * uint64_t(cy1 - cy0 + 1) > cells.size())
+    {
+      // Viewport spans more cells than are occupied: walk the occupied ones instead
+      for (const auto &[key, ids] : cells)
+      {
+        drawCell(ids, viewport, out);
+      }
+      return;
+    }
+    for (int cx = cx0; cx <= cx1; ++cx)
+    {
+      for (int cy = cy0; cy <= cy1; ++cy)
+      {
+        auto it = cells.find(cellKey(cx, cy));
+        if (it != cells.end())
+        {
+          drawCell(it->second, viewport, out);
+        }
+      }
+    }
+  }
+  // Buckets trees by type (in order of first appearance) and hands each type its positions in one call
+  void drawBatched(Sink &sink) const
+  {
+    unordered_map<const TreeType *, size_t> batchOf;
+    vector<pair<const TreeType *, vector<Position>>> batches;
+    for (const auto &tree : trees)
+    {
+      auto [it, added] = batchOf.try_emplace(tree.getType(), batches.size());
+      if (added)
+      {
+        batches.emplace_back(tree.getType(), vector<Position>());
+      }
+      batches[it->second].second.push_back({tree.getX(), tree.getY()});
+    }
+    for (const auto &[type, positions] : batches)
+    {
+      type->drawInstances(positions, sink);
+    }
+  }
+  // Reference full scan for a viewport, for comparison with the indexed draw
+  void drawLinear(const Rect &viewport, ostream &out = cout) const
+  {
+    for (const auto &tree : trees)
+    {
+      if (viewport.contains(tree.getX(), tree.getY()))
+      {
+        tree.draw(out);
+      }
+    }
+  }
+  size_t size() const { return trees.size(); }
 };
 
+// Flyweight Table: Interns tree types into a dense vector indexed by a small id
+class TreeTypeTable
+{
+  StringInterner strings;
+  vector<TreeType> types;
+  unordered_map<TreeKey, uint16_t, TreeKeyHash> ids;
+
+public:
+  static constexpr size_t maxTypes = UINT16_MAX + 1;
+
+  uint16_t getTreeTypeId(string_view name, string_view color, string_view texture)
+  {
+    auto it = ids.find(TreeKey{name, color, texture});
+    if (it != ids.end())
+    {
+      return it->second;
+    }
+    if (types.size() == maxTypes)
+    {
+      throw length_error("TreeTypeTable: more than 65536 tree types");
+    }
+    TreeKey key{strings.intern(name), strings.intern(color), strings.intern(texture)};
+    uint16_t id = static_cast<uint16_t>(types.size());
+    types.emplace_back(key.name, key.color, key.texture);
+    ids.try_emplace(key, id);
+    return id;
+  }
+  const TreeType &get(uint16_t id) const { return types[id]; }
+  size_t size() const { return types.size(); }
+};
+
+// Extrinsic state for bulk planting into a CompactForest
+struct TreePlacement
+{
+  int x, y;
+  uint16_t typeId;
+};
+
+// CompactForest: Same forest stored as struct-of-arrays with 16-bit type ids.
+// Single-threaded: drawBatched() reuses mutable scratch buffers, so even const draws must not run concurrently.
+class CompactForest
+{
+  vector<int> xs;
+  vector<int> ys;
+  vector<uint16_t> typeIds;
+  TreeTypeTable types;
+  mutable vector<size_t> batchOffsets; // Scratch buffers reused across drawBatched calls
+  mutable vector<Position> batchPositions;
+  mutable vector<size_t> batchCursor;
+
+public:
+  static constexpr size_t bytesPerTree = sizeof(int) * 2 + sizeof(uint16_t);
+
+  uint16_t getTreeTypeId(string_view name, string_view color, string_view texture)
+  {
+    return types.getTreeTypeId(name, color, texture);
+  }
+  void plantTree(int x, int y, const string &name, const string &color, const string &texture)
+  {
+    uint16_t id = types.getTreeTypeId(name, color, texture);
+    xs.push_back(x);
+    ys.push_back(y);
+    typeIds.push_back(id);
+  }
+  // Bulk insert; type ids must come from getTreeTypeId() of this forest
+  void plantTrees(span<const TreePlacement> placements)
+  {
+    size_t n = xs.size() + placements.size();
+    xs.reserve(n);
+    ys.reserve(n);
+    typeIds.reserve(n);
+    for (const auto &p : placements)
+    {
+      if (p.typeId >= types.size())
+      {
+        throw out_of_range("CompactForest::plantTrees: unknown tree type id");
+      }
+      xs.push_back(p.x);
+      ys.push_back(p.y);
+      typeIds.push_back(p.typeId);
+    }
+  }
+  void draw(ostream &out = cout) const
+  {
+    for (size_t i = 0; i < xs.size(); ++i)
+    {
+      types.get(typeIds[i]).draw(xs[i], ys[i], out);
+    }
+  }
+  // Counting sort by type id, then one contiguous span of positions per type
+  void drawBatched(Sink &sink) const
+  {
+    batchOffsets.assign(types.size() + 1, 0);
+    for (uint16_t id : typeIds)
+    {
+      ++batchOffsets[id + 1];
+    }
+    for (size_t t = 1; t < batchOffsets.size(); ++t)
+    {
+      batchOffsets[t] += batchOffsets[t - 1];
+    }
+    batchPositions.resize(xs.size());
+    batchCursor.assign(batchOffsets.begin(), batchOffsets.end() - 1);
+    for (size_t i = 0; i < xs.size(); ++i)
+    {
+      batchPositions[batchCursor[typeIds[i]]++] = {xs[i], ys[i]};
+    }
+    span<const Position> all(batchPositions);
+    for (size_t t = 0; t + 1 < batchOffsets.size(); ++t)
+    {
+      if (batchOffsets[t + 1] > batchOffsets[t])
+      {
+        types.get(uint16_t(t)).drawInstances(all.subspan(batchOffsets[t], batchOffsets[t + 1] - batchOffsets[t]), sink);
+      }
+    }
+  }
+  size_t size() const { return xs.size(); }
+};
+
+#ifndef DESIGN_PATTERNS_NO_MAIN
 int main()
 {
   Forest forest;
@@ -109,5 +551,33 @@ int main()
   cout << "Drawing the forest:\n";
   forest.draw();
 
+  cout << "\nDrawing only the viewport [0, 6) x [0, 7):\n";
+  forest.draw(Rect{0, 0, 6, 7});
+
+  CompactForest compact;
+  compact.plantTree(1, 2, "Oak", "Green", "Rough");
+  uint16_t pine = compact.getTreeTypeId("Pine", "Dark Green", "Smooth");
+  vector<TreePlacement> batch = {{3, 4, pine}, {11, 12, pine}};
+  compact.plantTrees(batch);
+
+  cout << "\nDrawing the compact forest:\n";
+  compact.draw();
+
+  cout << "\nDrawing both forests batched by tree type:\n";
+  ConsoleSink console;
+  forest.drawBatched(console);
+  compact.drawBatched(console);
+
+  // Chunks loaded on several threads share one concurrent factory
+  ConcurrentTreeFactory sharedTypes;
+  const TreeType *chunkTypes[2];
+  thread chunk0([&]() { chunkTypes[0] = sharedTypes.getTreeType("Oak", "Green", "Rough"); });
+  thread chunk1([&]() { chunkTypes[1] = sharedTypes.getTreeType("Oak", "Green", "Rough"); });
+  chunk0.join();
+  chunk1.join();
+  cout << "\nChunks share one Oak type: " << (chunkTypes[0] == chunkTypes[1] ? "yes" : "no") << endl;
+  chunkTypes[0]->draw(13, 14);
+
   return 0;
-}
\ No newline at end of file
+}
+#endif
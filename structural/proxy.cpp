@@ -19,6 +19,17 @@ Example: YouTube Video Service (Lazy Loading)
 ---------------------------------------------
 Suppose you have a service that fetches YouTube videos via the YouTube API. Creating the API object is expensive, so you want to delay its creation until it is actually needed (lazy loading).
 
+Caching Proxy:
+- YouTubeCachingProxy creates its upstream service on first use under call_once, so concurrent first calls are safe.
+- Fetched videos are kept in an LRU cache bounded by bytes (id plus data), not by entry count.
+- Concurrent requests for the same videoId share one upstream fetch: the first request starts it, later ones get
+  the same shared_future.
+- getVideoAsync() returns immediately with a future; a small pool of fetcher threads performs the upstream calls,
+  so callers do not need a thread per outstanding request. getVideo() is getVideoAsync().get().
+- prefetch() queues hints that fetchers serve only when no demand request is waiting; a demand request for a
+  queued hint is promoted ahead of the other hints.
+- stats() reports hits, misses, coalesced requests, upstream calls, prefetches and evictions.
+
 */
 
 #include <iostream>
@@ -26,6 +37,17 @@ Suppose you have a service that fetches YouTube videos via the YouTube API. Crea
 #include <memory>
 #include <thread>
 #include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <list>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <span>
+#include <stdexcept>
+#include <cstdint>
 using namespace std;
 
 // Subject interface
@@ -39,16 +61,18 @@ public:
 // RealSubject: Actual YouTube API service
 class YouTubeAPI : public YouTubeService
 {
+  chrono::milliseconds latency;
+
 public:
-  YouTubeAPI()
+  explicit YouTubeAPI(chrono::milliseconds l = chrono::milliseconds(1000)) : latency(l)
   {
     cout << "[YouTubeAPI] Initializing YouTube API connection..." << endl;
-    this_thread::sleep_for(chrono::milliseconds(1000));
+    this_thread::sleep_for(latency);
   }
   string getVideo(const string &videoId) override
   {
     cout << "[YouTubeAPI] Fetching video '" << videoId << "' from YouTube..." << endl;
-    this_thread::sleep_for(chrono::milliseconds(1000));
+    this_thread::sleep_for(latency);
     return "VideoData: " + videoId;
   }
 };
@@ -57,15 +81,16 @@ public:
 class YouTubeLazyProxy : public YouTubeService
 {
   unique_ptr<YouTubeAPI> api;
+  chrono::milliseconds latency;
 
 public:
-  YouTubeLazyProxy() : api(nullptr) {}
+  explicit YouTubeLazyProxy(chrono::milliseconds l = chrono::milliseconds(1000)) : api(nullptr), latency(l) {}
   string getVideo(const string &videoId) override
   {
     if (!api)
     {
       cout << "[Proxy] YouTubeAPI not initialized. Initializing now..." << endl;
-      api = make_unique<YouTubeAPI>();
+      api = make_unique<YouTubeAPI>(latency);
     }
     else
     {
@@ -75,6 +100,223 @@ public:
   }
 };
 
+struct CachingProxyOptions
+{
+  size_t cacheBytes = size_t(64) << 20;
+  size_t fetchers = 4;
+  size_t maxPrefetch = 256; // hints beyond this many queued are dropped
+  function<unique_ptr<YouTubeService>()> upstream; // defaults to a YouTubeAPI
+};
+
+struct CachingProxyStats
+{
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t coalesced = 0; // requests that joined a fetch already in flight
+  uint64_t upstreamCalls = 0;
+  uint64_t prefetches = 0; // hints that started an upstream fetch
+  uint64_t evictions = 0;
+  size_t cachedBytes = 0;
+};
+
+// Proxy: thread-safe lazy, caching, coalescing proxy for YouTubeService
+class YouTubeCachingProxy : public YouTubeService
+{
+  struct Entry
+  {
+    string id;
+    string data;
+  };
+
+  struct Flight
+  {
+    promise<string> result;
+    shared_future<string> shared;
+    bool started = false;
+  };
+
+  CachingProxyOptions options;
+  once_flag initialized;
+  unique_ptr<YouTubeService> api;
+
+  mutex lock;
+  condition_variable work;
+  list<Entry> lru; // most recently used first
+  unordered_map<string_view, list<Entry>::iterator> index; // views ids owned by lru
+  unordered_map<string, Flight> inFlight;
+  deque<string> demand;
+  deque<string> hints;
+  CachingProxyStats counters;
+  bool stopping = false;
+  vector<thread> fetchers;
+
+  static size_t bytesOf(const Entry &e) { return e.id.size() + e.data.size(); }
+
+  YouTubeService &upstream()
+  {
+    call_once(initialized, [this]()
+              { api = options.upstream ? options.upstream() : make_unique<YouTubeAPI>(); });
+    return *api;
+  }
+
+  // Caller holds lock
+  void insert(const string &id, const string &data)
+  {
+    Entry entry{id, data};
+    size_t bytes = bytesOf(entry);
+    if (bytes > options.cacheBytes)
+      return;
+    while (counters.cachedBytes + bytes > options.cacheBytes)
+    {
+      counters.cachedBytes -= bytesOf(lru.back());
+      index.erase(lru.back().id);
+      lru.pop_back();
+      ++counters.evictions;
+    }
+    lru.push_front(std::move(entry));
+    index[lru.front().id] = lru.begin();
+    counters.cachedBytes += bytes;
+  }
+
+  void fetchLoop()
+  {
+    unique_lock<mutex> guard(lock);
+    for (;;)
+    {
+      work.wait(guard, [&]()
+                { return stopping || !demand.empty() || !hints.empty(); });
+      if (stopping)
+        return;
+      bool isHint = demand.empty();
+      string id = std::move(isHint ? hints.front() : demand.front());
+      (isHint ? hints : demand).pop_front();
+      auto flight = inFlight.find(id);
+      if (flight == inFlight.end() || flight->second.started)
+        continue; // already fetched through a promoted copy of this id
+      flight->second.started = true;
+      ++counters.upstreamCalls;
+      counters.prefetches += isHint;
+      guard.unlock();
+
+      string data;
+      exception_ptr failure;
+      try
+      {
+        data = upstream().getVideo(id);
+      }
+      catch (...)
+      {
+        failure = current_exception();
+      }
+
+      guard.lock();
+      promise<string> result = std::move(inFlight.at(id).result);
+      inFlight.erase(id);
+      if (!failure)
+        insert(id, data);
+      guard.unlock();
+      if (failure)
+        result.set_exception(failure);
+      else
+        result.set_value(std::move(data));
+      guard.lock();
+    }
+  }
+
+  // Caller holds lock
+  shared_future<string> startFetch(const string &videoId, bool isHint)
+  {
+    Flight &flight = inFlight[videoId];
+    flight.shared = flight.result.get_future().share();
+    (isHint ? hints : demand).push_back(videoId);
+    work.notify_one();
+    return flight.shared;
+  }
+
+public:
+  explicit YouTubeCachingProxy(CachingProxyOptions opts = CachingProxyOptions()) : options(std::move(opts))
+  {
+    if (options.fetchers == 0)
+      throw invalid_argument("YouTubeCachingProxy: at least one fetcher is required");
+    for (size_t i = 0; i < options.fetchers; ++i)
+    {
+      fetchers.emplace_back(&YouTubeCachingProxy::fetchLoop, this);
+    }
+  }
+
+  // Requests still waiting for a fetch fail with runtime_error
+  ~YouTubeCachingProxy()
+  {
+    {
+      lock_guard<mutex> guard(lock);
+      stopping = true;
+    }
+    work.notify_all();
+    for (auto &f : fetchers)
+    {
+      f.join();
+    }
+    for (auto &[id, flight] : inFlight)
+    {
+      flight.result.set_exception(make_exception_ptr(runtime_error("YouTubeCachingProxy destroyed before '" + id + "' was fetched")));
+    }
+  }
+
+  YouTubeCachingProxy(const YouTubeCachingProxy &) = delete;
+  YouTubeCachingProxy &operator=(const YouTubeCachingProxy &) = delete;
+
+  shared_future<string> getVideoAsync(const string &videoId)
+  {
+    lock_guard<mutex> guard(lock);
+    auto cached = index.find(videoId);
+    if (cached != index.end())
+    {
+      ++counters.hits;
+      lru.splice(lru.begin(), lru, cached->second);
+      promise<string> ready;
+      ready.set_value(cached->second->data);
+      return ready.get_future().share();
+    }
+    auto flight = inFlight.find(videoId);
+    if (flight != inFlight.end())
+    {
+      ++counters.coalesced;
+      if (!flight->second.started)
+      {
+        demand.push_back(videoId); // promote a queued hint; the later copy is skipped
+        work.notify_one();
+      }
+      return flight->second.shared;
+    }
+    ++counters.misses;
+    return startFetch(videoId, false);
+  }
+
+  string getVideo(const string &videoId) override
+  {
+    return getVideoAsync(videoId).get();
+  }
+
+  // Hints that these videos will be requested soon; ids already cached or in flight are ignored
+  void prefetch(span<const string> videoIds)
+  {
+    lock_guard<mutex> guard(lock);
+    for (const auto &id : videoIds)
+    {
+      if (hints.size() >= options.maxPrefetch)
+        break;
+      if (!index.count(id) && !inFlight.count(id))
+        startFetch(id, true);
+    }
+  }
+
+  CachingProxyStats stats()
+  {
+    lock_guard<mutex> guard(lock);
+    return counters;
+  }
+};
+
 // Client code
 void clientCode(YouTubeService *service)
 {
@@ -82,6 +324,7 @@ void clientCode(YouTubeService *service)
   cout << service->getVideo("xyz789") << endl;
 }
 
+#ifndef DESIGN_PATTERNS_NO_MAIN
 int main()
 {
   YouTubeLazyProxy proxy;
@@ -89,5 +332,33 @@ int main()
   cout << "Fetching videos via lazy proxy:\n";
   clientCode(&proxy);
 
+  cout << "\nFetching videos via caching proxy:\n";
+  CachingProxyOptions options;
+  options.upstream = []()
+  { return make_unique<YouTubeAPI>(chrono::milliseconds(200)); };
+  YouTubeCachingProxy caching(options);
+  clientCode(&caching);
+  clientCode(&caching); // served from the cache
+
+  // Three concurrent requests for one video share a single upstream fetch
+  vector<shared_future<string>> pending;
+  for (int i = 0; i < 3; ++i)
+  {
+    pending.push_back(caching.getVideoAsync("lmn456"));
+  }
+  for (auto &f : pending)
+  {
+    cout << f.get() << endl;
+  }
+
+  const string hinted[] = {"qrs000"};
+  caching.prefetch(hinted);
+  cout << caching.getVideo("qrs000") << endl;
+
+  CachingProxyStats stats = caching.stats();
+  cout << "Upstream calls: " << stats.upstreamCalls << ", hits: " << stats.hits << ", coalesced: "
+       << stats.coalesced << ", prefetched: " << stats.prefetches << endl;
+
   return 0;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file